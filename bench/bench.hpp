@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace bench
+{
+
+/**
+ * Options shared by all benchmark scenarios, filled in from the command line.
+ */
+struct Options
+{
+    std::size_t ops = 100000;
+};
+
+/**
+ * Swallows a value so the compiler can not optimize away the computation that produced it.
+ */
+template <class T>
+inline void do_not_optimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * Deterministic xorshift generator, so every run sees the same error pattern.
+ */
+class Rng
+{
+public:
+    explicit Rng(std::uint64_t seed) : state_(seed)
+    {
+    }
+
+    std::uint64_t next()
+    {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return state_;
+    }
+
+private:
+    std::uint64_t state_;
+};
+
+/**
+ * Builds a pattern of `len` flags of which exactly `percent`% are set, in shuffled order.
+ */
+inline std::vector<bool> error_pattern(std::size_t len, unsigned percent)
+{
+    std::vector<bool> pattern(len, false);
+    std::size_t errors = len * percent / 100;
+
+    for (std::size_t i = 0; i < errors; i++)
+    {
+        pattern[i] = true;
+    }
+
+    Rng rng(0x9e3779b97f4a7c15ULL ^ percent);
+    for (std::size_t i = len - 1; i > 0; i--)
+    {
+        std::size_t j = rng.next() % (i + 1);
+        bool tmp = pattern[i];
+        pattern[i] = pattern[j];
+        pattern[j] = tmp;
+    }
+    return pattern;
+}
+
+/**
+ * Runs `fn(i)` for i in [0, ops) and returns the average time per call in nanoseconds.
+ */
+template <class F>
+double ns_per_op(std::size_t ops, F&& fn)
+{
+    // warm up caches and branch predictors
+    for (std::size_t i = 0; i < ops / 10; i++)
+    {
+        fn(i);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < ops; i++)
+    {
+        fn(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - start).count() / ops;
+}
+
+inline void print_header(const char* scenario)
+{
+    std::printf("# %s\n", scenario);
+    std::printf("%-12s %6s %6s %10s\n", "strategy", "depth", "err%", "ns/op");
+}
+
+inline void print_row(const char* strategy, int depth, unsigned percent, double ns)
+{
+    std::printf("%-12s %6d %6u %10.2f\n", strategy, depth, percent, ns);
+}
+
+void run_chains(const Options& opts);
+void run_sys(const Options& opts);
+void run_mapped_file(const Options& opts);
+void run_counters(const Options& opts);
+void run_messages(const Options& opts);
+
+} // namespace bench
@@ -0,0 +1,186 @@
+// SPDX-License-Identifier: MIT
+
+// Deep call chains that propagate a failure from the innermost frame to the caller,
+// once for every error handling strategy we want to compare.
+
+#include "bench.hpp"
+
+#include <bowl/error.hpp>
+#include <bowl/expected.hpp>
+#include <bowl/macros.hpp>
+#include <bowl/maybe_error.hpp>
+
+#include <cerrno>
+
+namespace bench
+{
+namespace
+{
+
+/* bowl::Expected */
+[[gnu::noinline]] bowl::Expected<int, bowl::ErrnoError> expected_chain(int depth, bool fail, int v)
+{
+    if (depth == 0)
+    {
+        if (fail)
+        {
+            errno = EINVAL;
+            return bowl::Unexpected(bowl::ErrnoError());
+        }
+        return v + 1;
+    }
+
+    CHECK_ASSIGN(res, expected_chain(depth - 1, fail, v));
+    return res + 1;
+}
+
+/* bowl::Expected without any checks */
+using UncheckedExpected = bowl::Expected<int, bowl::ErrnoError, bowl::policy::Unchecked>;
+
+[[gnu::noinline]] UncheckedExpected unchecked_chain(int depth, bool fail, int v)
+{
+    if (depth == 0)
+    {
+        if (fail)
+        {
+            errno = EINVAL;
+            return bowl::Unexpected<bowl::ErrnoError, bowl::policy::Unchecked>(bowl::ErrnoError());
+        }
+        return v + 1;
+    }
+
+    CHECK_ASSIGN(res, unchecked_chain(depth - 1, fail, v));
+    return res + 1;
+}
+
+/* bowl::MaybeError, value returned through an out parameter */
+[[gnu::noinline]] bowl::MaybeError<bowl::ErrnoError> maybe_error_chain(int depth, bool fail, int v,
+                                                                       int& out)
+{
+    if (depth == 0)
+    {
+        if (fail)
+        {
+            errno = EINVAL;
+            return bowl::ErrnoError();
+        }
+        out = v + 1;
+        return bowl::MaybeError<bowl::ErrnoError>();
+    }
+
+    auto res = maybe_error_chain(depth - 1, fail, v, out);
+    if (!res.ok())
+    {
+        return bowl::Unexpected(res.unpack_error());
+    }
+    out += 1;
+    return bowl::MaybeError<bowl::ErrnoError>();
+}
+
+/* raw negative errno return code, value returned through an out parameter */
+[[gnu::noinline]] int errno_chain(int depth, bool fail, int v, int& out)
+{
+    if (depth == 0)
+    {
+        if (fail)
+        {
+            return -EINVAL;
+        }
+        out = v + 1;
+        return 0;
+    }
+
+    int ret = errno_chain(depth - 1, fail, v, out);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    out += 1;
+    return 0;
+}
+
+/* C++ exceptions */
+[[gnu::noinline]] int exception_chain(int depth, bool fail, int v)
+{
+    if (depth == 0)
+    {
+        if (fail)
+        {
+            errno = EINVAL;
+            bowl::ErrnoError().throw_as_exception();
+        }
+        return v + 1;
+    }
+
+    return exception_chain(depth - 1, fail, v) + 1;
+}
+
+constexpr int depths[] = { 1, 2, 4, 8, 16, 32, 64 };
+constexpr unsigned error_rates[] = { 0, 1, 5, 10, 25, 50, 100 };
+constexpr std::size_t pattern_len = 1024;
+
+} // namespace
+
+void run_chains(const Options& opts)
+{
+    print_header("call chains");
+
+    for (unsigned rate : error_rates)
+    {
+        std::vector<bool> pattern = error_pattern(pattern_len, rate);
+
+        for (int depth : depths)
+        {
+            print_row("expected", depth, rate, ns_per_op(opts.ops, [&](std::size_t i) {
+                          auto res =
+                              expected_chain(depth, pattern[i % pattern_len], static_cast<int>(i));
+                          int v = res.ok() ? res.unpack_ok() : -1;
+                          do_not_optimize(v);
+                      }));
+
+            print_row("unchecked", depth, rate, ns_per_op(opts.ops, [&](std::size_t i) {
+                          auto res =
+                              unchecked_chain(depth, pattern[i % pattern_len], static_cast<int>(i));
+                          int v = res.ok() ? res.unpack_ok() : -1;
+                          do_not_optimize(v);
+                      }));
+
+            print_row("maybe_error", depth, rate, ns_per_op(opts.ops, [&](std::size_t i) {
+                          int v = 0;
+                          auto res = maybe_error_chain(depth, pattern[i % pattern_len],
+                                                       static_cast<int>(i), v);
+                          if (!res.ok())
+                          {
+                              v = -1;
+                          }
+                          do_not_optimize(v);
+                      }));
+
+            print_row("errno", depth, rate, ns_per_op(opts.ops, [&](std::size_t i) {
+                          int v = 0;
+                          if (errno_chain(depth, pattern[i % pattern_len], static_cast<int>(i), v) <
+                              0)
+                          {
+                              v = -1;
+                          }
+                          do_not_optimize(v);
+                      }));
+
+            print_row("exception", depth, rate, ns_per_op(opts.ops, [&](std::size_t i) {
+                          int v;
+                          try
+                          {
+                              v = exception_chain(depth, pattern[i % pattern_len],
+                                                  static_cast<int>(i));
+                          }
+                          catch (bowl::ErrnoException&)
+                          {
+                              v = -1;
+                          }
+                          do_not_optimize(v);
+                      }));
+        }
+    }
+}
+
+} // namespace bench
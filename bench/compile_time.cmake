@@ -0,0 +1,54 @@
+# SPDX-License-Identifier: MIT
+#
+# Front-end time per translation unit for including each bowl header, compared with an empty
+# translation unit. Every TU is only parsed and checked (-fsyntax-only), `ITERATIONS` times.
+#
+# Usage: cmake -DCXX=... -DSTD_FLAG=... -DINCLUDE_DIR=... -DWORK_DIR=... -DITERATIONS=...
+#              -P compile_time.cmake
+
+set(headers fwd.hpp macros.hpp expected.hpp maybe_error.hpp error.hpp any_error.hpp
+    error_set.hpp catalog.hpp context.hpp sys.hpp mapped_file.hpp)
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+# Microseconds spent compiling `source` ITERATIONS times
+function(time_tu source out)
+    string(TIMESTAMP start "%s%f")
+    foreach(i RANGE 1 ${ITERATIONS})
+        execute_process(COMMAND ${CXX} ${STD_FLAG} -fsyntax-only -I${INCLUDE_DIR} ${source}
+            RESULT_VARIABLE result)
+        if(NOT result EQUAL 0)
+            message(FATAL_ERROR "compiling ${source} failed")
+        endif()
+    endforeach()
+    string(TIMESTAMP end "%s%f")
+
+    math(EXPR us "(${end} - ${start}) / ${ITERATIONS}")
+    set(${out} ${us} PARENT_SCOPE)
+endfunction()
+
+function(print_row name us baseline)
+    math(EXPR ms "${us} / 1000")
+    math(EXPR frac "${us} % 1000 / 100")
+    math(EXPR over "(${us} - ${baseline}) / 1000")
+    if(over LESS 0)
+        set(over 0)
+    endif()
+    string(LENGTH "${name}" len)
+    math(EXPR pad "24 - ${len}")
+    string(REPEAT " " ${pad} spaces)
+    message("${name}${spaces}${ms}.${frac} ms  (+${over} ms)")
+endfunction()
+
+file(WRITE ${WORK_DIR}/empty.cpp "")
+time_tu(${WORK_DIR}/empty.cpp baseline)
+
+message("# front-end time per TU, ${ITERATIONS} iterations")
+print_row("(empty)" ${baseline} ${baseline})
+
+foreach(header ${headers})
+    string(REPLACE "." "_" name ${header})
+    file(WRITE ${WORK_DIR}/${name}.cpp "#include <bowl/${header}>\n")
+    time_tu(${WORK_DIR}/${name}.cpp us)
+    print_row("<bowl/${header}>" ${us} ${baseline})
+endforeach()
@@ -0,0 +1,341 @@
+// SPDX-License-Identifier: MIT
+
+// Hardware counters (instructions, branches, branch misses and L1 instruction cache misses) per
+// call of every error handling strategy, read through perf_event_open(). They show where the
+// time of the wall-clock numbers goes, e.g. whether an error path mispredicts branches.
+
+#include "bench.hpp"
+
+#include <bowl/error.hpp>
+#include <bowl/expected.hpp>
+#include <bowl/macros.hpp>
+#include <bowl/maybe_error.hpp>
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace bench
+{
+namespace
+{
+
+/**
+ * Counters of the calling thread in user space. Every counter is opened on its own, so counters
+ * which the CPU or the kernel does not offer (in VMs, or with a restrictive
+ * perf_event_paranoid) are just left out.
+ */
+class PerfCounters
+{
+public:
+    enum Counter
+    {
+        instructions,
+        branches,
+        branch_misses,
+        l1i_misses,
+        num_counters,
+    };
+
+    /**
+     * Counts per call, or a negative value for counters that are not available.
+     */
+    struct Sample
+    {
+        double ns;
+        std::array<double, num_counters> per_op;
+    };
+
+    PerfCounters()
+    {
+        constexpr std::uint64_t l1i_read_miss = PERF_COUNT_HW_CACHE_L1I |
+                                                (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+        open(instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        open(branches, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS);
+        open(branch_misses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        open(l1i_misses, PERF_TYPE_HW_CACHE, l1i_read_miss);
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    ~PerfCounters()
+    {
+        for (int fd : fds_)
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+        }
+    }
+
+    bool any() const
+    {
+        for (int fd : fds_)
+        {
+            if (fd >= 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Why the first unavailable counter could not be opened.
+     */
+    bowl::Errno error() const
+    {
+        return error_;
+    }
+
+    /**
+     * Runs `fn(i)` for i in [0, ops), like ns_per_op(), and returns the time and the counters
+     * per call.
+     */
+    template <class F>
+    Sample measure(std::size_t ops, F&& fn)
+    {
+        Sample sample;
+
+        // warm up caches and branch predictors
+        for (std::size_t i = 0; i < ops / 10; i++)
+        {
+            fn(i);
+        }
+
+        control(PERF_EVENT_IOC_RESET);
+        control(PERF_EVENT_IOC_ENABLE);
+
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < ops; i++)
+        {
+            fn(i);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        control(PERF_EVENT_IOC_DISABLE);
+
+        sample.ns = std::chrono::duration<double, std::nano>(end - start).count() / ops;
+        for (std::size_t c = 0; c < num_counters; c++)
+        {
+            sample.per_op[c] = read(fds_[c]) / ops;
+        }
+        return sample;
+    }
+
+private:
+    void open(Counter counter, std::uint32_t type, std::uint64_t config)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        int fd = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+
+        if (fd < 0 && error_ == bowl::Errno{})
+        {
+            error_ = static_cast<bowl::Errno>(errno);
+        }
+        fds_[counter] = fd;
+    }
+
+    void control(unsigned long request)
+    {
+        for (int fd : fds_)
+        {
+            if (fd >= 0)
+            {
+                ::ioctl(fd, request, 0);
+            }
+        }
+    }
+
+    /**
+     * The value of a counter, scaled up if the kernel had to multiplex it with other counters.
+     */
+    static double read(int fd)
+    {
+        struct
+        {
+            std::uint64_t value;
+            std::uint64_t enabled;
+            std::uint64_t running;
+        } data;
+
+        if (fd < 0 || ::read(fd, &data, sizeof(data)) != sizeof(data) || data.running == 0)
+        {
+            return -1;
+        }
+        return static_cast<double>(data.value) * data.enabled / data.running;
+    }
+
+    std::array<int, num_counters> fds_;
+    bowl::Errno error_{};
+};
+
+/* bowl::Expected */
+[[gnu::noinline]] bowl::Expected<int, bowl::ErrnoError> expected_return(bool fail, int v)
+{
+    if (fail)
+    {
+        return bowl::Unexpected(bowl::ErrnoError(bowl::Errno::INVAL));
+    }
+    return v + 1;
+}
+
+/* bowl::MaybeError */
+[[gnu::noinline]] bowl::MaybeError<bowl::ErrnoError> maybe_error_return(bool fail)
+{
+    if (fail)
+    {
+        return bowl::Unexpected(bowl::ErrnoError(bowl::Errno::INVAL));
+    }
+    return {};
+}
+
+/* bowl::Expected, propagated through CHECK_ASSIGN */
+[[gnu::noinline]] bowl::Expected<int, bowl::ErrnoError> check_assign_chain(int depth, bool fail,
+                                                                           int v)
+{
+    if (depth == 0)
+    {
+        return expected_return(fail, v);
+    }
+
+    CHECK_ASSIGN(res, check_assign_chain(depth - 1, fail, v));
+    return res + 1;
+}
+
+/* C++ exceptions, as a baseline */
+[[gnu::noinline]] int exception_return(bool fail, int v)
+{
+    if (fail)
+    {
+        bowl::ErrnoError(bowl::Errno::INVAL).throw_as_exception();
+    }
+    return v + 1;
+}
+
+constexpr int chain_depth = 8;
+constexpr unsigned error_rates[] = { 0, 1, 10, 50 };
+constexpr std::size_t pattern_len = 1024;
+
+const char* const counter_names[] = { "instr/op", "branch/op", "brmiss/op", "l1imiss/op" };
+
+void print_counters_header()
+{
+    std::printf("# hardware counters\n");
+    std::printf("%-15s %6s %10s", "strategy", "err%", "ns/op");
+    for (const char* name : counter_names)
+    {
+        std::printf(" %10s", name);
+    }
+    std::printf("\n");
+}
+
+void print_counters_row(const char* strategy, unsigned percent,
+                        const PerfCounters::Sample& sample)
+{
+    std::printf("%-15s %6u %10.2f", strategy, percent, sample.ns);
+    for (double value : sample.per_op)
+    {
+        if (value < 0)
+        {
+            std::printf(" %10s", "n/a");
+        }
+        else
+        {
+            std::printf(" %10.3f", value);
+        }
+    }
+    std::printf("\n");
+}
+
+} // namespace
+
+void run_counters(const Options& opts)
+{
+    PerfCounters counters;
+
+    if (!counters.any())
+    {
+        // The name is empty for errnos missing from the table, so print the number as well
+        bowl::ErrnoInfo info = bowl::errno_info(counters.error());
+
+        std::fprintf(stderr,
+                     "bench: hardware counters not available (errno %d %.*s: %.*s), only "
+                     "measuring time. Check /proc/sys/kernel/perf_event_paranoid.\n",
+                     static_cast<int>(counters.error()), static_cast<int>(info.name.size()),
+                     info.name.data(), static_cast<int>(info.description.size()),
+                     info.description.data());
+    }
+
+    print_counters_header();
+
+    for (unsigned rate : error_rates)
+    {
+        std::vector<bool> pattern = error_pattern(pattern_len, rate);
+
+        print_counters_row("expected", rate, counters.measure(opts.ops, [&](std::size_t i) {
+            auto res = expected_return(pattern[i % pattern_len], static_cast<int>(i));
+            int v = res.ok() ? res.unpack_ok() : -1;
+            do_not_optimize(v);
+        }));
+
+        print_counters_row("maybe_error", rate, counters.measure(opts.ops, [&](std::size_t i) {
+            auto res = maybe_error_return(pattern[i % pattern_len]);
+            int v = res.ok() ? 0 : -1;
+            do_not_optimize(v);
+        }));
+
+        print_counters_row("check_assign", rate, counters.measure(opts.ops, [&](std::size_t i) {
+            auto res =
+                check_assign_chain(chain_depth, pattern[i % pattern_len], static_cast<int>(i));
+            int v = res.ok() ? res.unpack_ok() : -1;
+            do_not_optimize(v);
+        }));
+
+        print_counters_row("throw_if_error", rate, counters.measure(opts.ops, [&](std::size_t i) {
+            int v = 0;
+            try
+            {
+                maybe_error_return(pattern[i % pattern_len]).throw_if_error();
+            }
+            catch (bowl::ErrnoException&)
+            {
+                v = -1;
+            }
+            do_not_optimize(v);
+        }));
+
+        print_counters_row("exception", rate, counters.measure(opts.ops, [&](std::size_t i) {
+            int v;
+            try
+            {
+                v = exception_return(pattern[i % pattern_len], static_cast<int>(i));
+            }
+            catch (bowl::ErrnoException&)
+            {
+                v = -1;
+            }
+            do_not_optimize(v);
+        }));
+    }
+}
+
+} // namespace bench
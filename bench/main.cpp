@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: MIT
+
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+static void usage(const char* argv0)
+{
+    std::fprintf(stderr, "Usage: %s [--ops N] [chains|sys|mapped_file|counters|messages]\n", argv0);
+}
+
+int main(int argc, char** argv)
+{
+    bench::Options opts;
+    const char* scenario = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--ops") == 0 && i + 1 < argc)
+        {
+            opts.ops = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (argv[i][0] != '-' && scenario == nullptr)
+        {
+            scenario = argv[i];
+        }
+        else
+        {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (scenario == nullptr || std::strcmp(scenario, "chains") == 0)
+    {
+        bench::run_chains(opts);
+    }
+    else if (std::strcmp(scenario, "sys") == 0)
+    {
+        bench::run_sys(opts);
+    }
+    else if (std::strcmp(scenario, "mapped_file") == 0)
+    {
+        bench::run_mapped_file(opts);
+    }
+    else if (std::strcmp(scenario, "counters") == 0)
+    {
+        bench::run_counters(opts);
+    }
+    else if (std::strcmp(scenario, "messages") == 0)
+    {
+        bench::run_messages(opts);
+    }
+    else
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
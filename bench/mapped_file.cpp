@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: MIT
+
+// Startup cost of loading a large read-only data file: reading it into a buffer against
+// mapping it with bowl::MappedFile and the different mapping options, each followed by
+// touching every page once. The file is in the page cache for all but the first run.
+
+#include "bench.hpp"
+
+#include <bowl/mapped_file.hpp>
+#include <bowl/sys.hpp>
+
+#include <cstdlib>
+
+#include <unistd.h>
+
+namespace bench
+{
+namespace
+{
+
+constexpr std::size_t file_size = 64 << 20;
+constexpr std::size_t page_size = 4096;
+constexpr int runs = 5;
+
+unsigned touch_pages(const unsigned char* data, std::size_t size)
+{
+    unsigned sum = 0;
+
+    for (std::size_t i = 0; i < size; i += page_size)
+    {
+        sum += data[i];
+    }
+    return sum;
+}
+
+template <class F>
+double ms_per_run(F&& fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < runs; i++)
+    {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::milli>(end - start).count() / runs;
+}
+
+void map_and_touch(const char* path, bowl::MappedFile::Options opts)
+{
+    auto file = bowl::MappedFile::open(path, opts);
+    if (!file.ok())
+    {
+        std::fprintf(stderr, "bench: %s\n", file.unpack_error().display().data());
+        std::exit(EXIT_FAILURE);
+    }
+
+    bowl::MappedFile mapped = file.unpack_ok();
+    do_not_optimize(touch_pages(mapped.data(), mapped.size()));
+}
+
+} // namespace
+
+void run_mapped_file(const Options&)
+{
+    char path[] = "/tmp/bowl_bench_XXXXXX";
+    int fd = mkstemp(path);
+    std::vector<unsigned char> buf(file_size, 0x5a);
+
+    if (fd < 0 || !bowl::sys::write(fd, buf.data(), buf.size()).ok())
+    {
+        std::perror("bench: setup");
+        std::exit(EXIT_FAILURE);
+    }
+    bowl::sys::close(fd);
+
+    using Access = bowl::MappedFile::Access;
+
+    std::printf("# mapped file startup, %zu MiB\n", file_size >> 20);
+    std::printf("%-20s %10s\n", "strategy", "ms");
+
+    std::printf("%-20s %10.2f\n", "read", ms_per_run([&] {
+                    int in = bowl::sys::open(path, O_RDONLY).unpack_ok();
+                    bowl::sys::read(in, buf.data(), buf.size());
+                    bowl::sys::close(in);
+                    do_not_optimize(touch_pages(buf.data(), buf.size()));
+                }));
+    std::printf("%-20s %10.2f\n", "mmap", ms_per_run([&] { map_and_touch(path, {}); }));
+    std::printf("%-20s %10.2f\n", "mmap sequential",
+                ms_per_run([&] { map_and_touch(path, { Access::sequential, false, false }); }));
+    std::printf("%-20s %10.2f\n", "mmap populate",
+                ms_per_run([&] { map_and_touch(path, { Access::normal, true, false }); }));
+    std::printf("%-20s %10.2f\n", "mmap populate huge",
+                ms_per_run([&] { map_and_touch(path, { Access::normal, true, true }); }));
+
+    unlink(path);
+}
+
+} // namespace bench
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: MIT
+
+// Errors with a message that depends on runtime values, propagated through CHECK_ASSIGN and then
+// dropped, as most errors are. The message is either built eagerly into a CustomError, or captured
+// by a FormattedError and only formatted if it is displayed.
+
+#include "bench.hpp"
+
+#include <bowl/error.hpp>
+#include <bowl/expected.hpp>
+#include <bowl/macros.hpp>
+
+#include <string>
+
+namespace bench
+{
+namespace
+{
+
+/* bowl::CustomError, message concatenated when the error is created */
+[[gnu::noinline]] bowl::Expected<int, bowl::CustomError> custom_chain(int depth, bool fail, int v)
+{
+    if (depth == 0)
+    {
+        if (fail)
+        {
+            return bowl::Unexpected(bowl::CustomError("short read: " + std::to_string(v) + " of " +
+                                                      std::to_string(v + 4096) + " bytes"));
+        }
+        return v + 1;
+    }
+
+    CHECK_ASSIGN(res, custom_chain(depth - 1, fail, v));
+    return res + 1;
+}
+
+/* bowl::FormattedError, message formatted on display() */
+[[gnu::noinline]] bowl::Expected<int, bowl::FormattedError> formatted_chain(int depth, bool fail,
+                                                                            int v)
+{
+    if (depth == 0)
+    {
+        if (fail)
+        {
+            return bowl::Unexpected(
+                bowl::FormattedError("short read: {} of {} bytes", v, v + 4096));
+        }
+        return v + 1;
+    }
+
+    CHECK_ASSIGN(res, formatted_chain(depth - 1, fail, v));
+    return res + 1;
+}
+
+constexpr int depths[] = { 1, 8 };
+constexpr unsigned error_rates[] = { 0, 1, 10, 50, 100 };
+constexpr std::size_t pattern_len = 1024;
+
+} // namespace
+
+void run_messages(const Options& opts)
+{
+    print_header("error messages");
+
+    for (unsigned rate : error_rates)
+    {
+        std::vector<bool> pattern = error_pattern(pattern_len, rate);
+
+        for (int depth : depths)
+        {
+            print_row("custom", depth, rate, ns_per_op(opts.ops, [&](std::size_t i) {
+                          auto res =
+                              custom_chain(depth, pattern[i % pattern_len], static_cast<int>(i));
+                          int v = res.ok() ? res.unpack_ok() : -1;
+                          do_not_optimize(v);
+                      }));
+
+            print_row("formatted", depth, rate, ns_per_op(opts.ops, [&](std::size_t i) {
+                          auto res =
+                              formatted_chain(depth, pattern[i % pattern_len], static_cast<int>(i));
+                          int v = res.ok() ? res.unpack_ok() : -1;
+                          do_not_optimize(v);
+                      }));
+
+            // the price of formatting, when the message is needed after all
+            print_row("formatted+d", depth, rate, ns_per_op(opts.ops, [&](std::size_t i) {
+                          auto res =
+                              formatted_chain(depth, pattern[i % pattern_len], static_cast<int>(i));
+                          int v = res.ok() ? res.unpack_ok()
+                                           : static_cast<int>(res.unpack_error().display().size());
+                          do_not_optimize(v);
+                      }));
+        }
+    }
+}
+
+} // namespace bench
@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: MIT
+
+// The bowl::sys wrappers against the raw libc calls they wrap, on cheap file descriptors,
+// so that the syscall itself is as small as possible compared to the error handling.
+
+#include "bench.hpp"
+
+#include <bowl/sys.hpp>
+
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace bench
+{
+namespace
+{
+
+constexpr std::size_t chunk = 64;
+
+void print_sys_header()
+{
+    std::printf("# syscalls\n");
+    std::printf("%-12s %-16s %10s\n", "strategy", "call", "ns/op");
+}
+
+void print_sys_row(const char* strategy, const char* call, double ns)
+{
+    std::printf("%-12s %-16s %10.2f\n", strategy, call, ns);
+}
+
+} // namespace
+
+void run_sys(const Options& opts)
+{
+    int zero_fd = ::open("/dev/zero", O_RDONLY);
+    int null_fd = ::open("/dev/null", O_WRONLY);
+    int efd = ::eventfd(0, EFD_NONBLOCK);
+
+    if (zero_fd < 0 || null_fd < 0 || efd < 0)
+    {
+        std::perror("bench: setup");
+        std::exit(EXIT_FAILURE);
+    }
+
+    char buf[chunk] = {};
+    std::uint64_t counter = 1;
+
+    print_sys_header();
+
+    print_sys_row("libc", "read", ns_per_op(opts.ops, [&](std::size_t) {
+                      ssize_t n = ::read(zero_fd, buf, chunk);
+                      do_not_optimize(n < 0 ? -1 : n);
+                  }));
+    print_sys_row("bowl", "read", ns_per_op(opts.ops, [&](std::size_t) {
+                      auto res = bowl::sys::read(zero_fd, buf, chunk);
+                      do_not_optimize(res.ok() ? static_cast<ssize_t>(res.unpack_ok()) : -1);
+                  }));
+
+    print_sys_row("libc", "pread", ns_per_op(opts.ops, [&](std::size_t) {
+                      ssize_t n = ::pread(zero_fd, buf, chunk, 0);
+                      do_not_optimize(n < 0 ? -1 : n);
+                  }));
+    print_sys_row("bowl", "pread", ns_per_op(opts.ops, [&](std::size_t) {
+                      auto res = bowl::sys::pread(zero_fd, buf, chunk, 0);
+                      do_not_optimize(res.ok() ? static_cast<ssize_t>(res.unpack_ok()) : -1);
+                  }));
+
+    print_sys_row("libc", "write", ns_per_op(opts.ops, [&](std::size_t) {
+                      ssize_t n = ::write(null_fd, buf, chunk);
+                      do_not_optimize(n < 0 ? -1 : n);
+                  }));
+    print_sys_row("bowl", "write", ns_per_op(opts.ops, [&](std::size_t) {
+                      auto res = bowl::sys::write(null_fd, buf, chunk);
+                      do_not_optimize(res.ok() ? static_cast<ssize_t>(res.unpack_ok()) : -1);
+                  }));
+
+    print_sys_row("libc", "eventfd rw", ns_per_op(opts.ops, [&](std::size_t) {
+                      ssize_t w = ::write(efd, &counter, sizeof(counter));
+                      ssize_t r = ::read(efd, &counter, sizeof(counter));
+                      do_not_optimize(w < 0 || r < 0 ? -1 : r);
+                  }));
+    print_sys_row("bowl", "eventfd rw", ns_per_op(opts.ops, [&](std::size_t) {
+                      auto w = bowl::sys::write(efd, &counter, sizeof(counter));
+                      auto r = bowl::sys::read(efd, &counter, sizeof(counter));
+                      do_not_optimize(w.ok() && r.ok() ? static_cast<ssize_t>(r.unpack_ok()) : -1);
+                  }));
+
+    // the error path: EBADF is detected in the kernel before doing any work
+    print_sys_row("libc", "read EBADF", ns_per_op(opts.ops, [&](std::size_t) {
+                      ssize_t n = ::read(-1, buf, chunk);
+                      do_not_optimize(n < 0 ? errno : 0);
+                  }));
+    print_sys_row("bowl", "read EBADF", ns_per_op(opts.ops, [&](std::size_t) {
+                      auto res = bowl::sys::read(-1, buf, chunk);
+                      do_not_optimize(res.ok() ? 0 : static_cast<int>(res.unpack_error().errnum()));
+                  }));
+
+    ::close(efd);
+    ::close(null_fd);
+    ::close(zero_fd);
+}
+
+} // namespace bench
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: MIT
+
+// Errors from the error catalog. `catalog --dump-catalog` prints the catalog as JSON lines, which
+// is how a log pipeline learns the messages of the ids it receives.
+
+#include <bowl/catalog.hpp>
+#include <bowl/expected.hpp>
+
+#include <cstdio>
+#include <cstring>
+
+BOWL_CATALOG_ERROR(NegativeNumber, 0x0001, "math", "can not take the root of {}");
+BOWL_CATALOG_ERROR(TooLarge, 0x0002, "math", "{} is larger than {}");
+
+bowl::Expected<int, bowl::CatalogError> int_root(int num)
+{
+    if (num < 0)
+    {
+        return bowl::Unexpected(bowl::CatalogError(NegativeNumber{}, num));
+    }
+    if (num > 1000000)
+    {
+        return bowl::Unexpected(bowl::CatalogError(TooLarge{}, num, 1000000));
+    }
+
+    int root = 0;
+    while ((root + 1) * (root + 1) <= num)
+    {
+        root++;
+    }
+    return root;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && std::strcmp(argv[1], "--dump-catalog") == 0)
+    {
+        bowl::dump_catalog(stdout);
+        return 0;
+    }
+
+    for (int num : { 49, -4, 2000000 })
+    {
+        auto res = int_root(num);
+
+        if (res.ok())
+        {
+            std::printf("root of %d: %d\n", num, res.unpack_ok());
+        }
+        else
+        {
+            auto err = res.unpack_error();
+            std::printf("error %u: %s\n", static_cast<unsigned>(err.id()), err.display().c_str());
+        }
+    }
+    return 0;
+}
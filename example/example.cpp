@@ -6,15 +6,15 @@
 #include <cmath>
 #include <iostream>
 
-class NegativeNumberError : bowl::Error
+class NegativeNumberError
 {
 public:
-    std::string display() const override
+    std::string display() const
     {
         return "Can not take root of negative number!";
     }
 
-    [[noreturn]] void throw_as_exception() const override
+    [[noreturn]] void throw_as_exception() const
     {
         throw std::runtime_error(display());
     }
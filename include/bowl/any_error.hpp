@@ -0,0 +1,296 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <bowl/error_traits.hpp>
+#include <bowl/exception.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace bowl
+{
+
+namespace detail
+{
+
+/**
+ * A string that names E, and is the same in every shared library of the program.
+ */
+template <class E>
+constexpr const char* type_key()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __PRETTY_FUNCTION__;
+#elif defined(_MSC_VER)
+    return __FUNCSIG__;
+#else
+#error "bowl::AnyError needs __PRETTY_FUNCTION__ or __FUNCSIG__"
+#endif
+}
+
+constexpr std::uint64_t hash_type_key(const char* key)
+{
+    std::uint64_t hash = 14695981039346656037ull;
+
+    for (; *key != '\0'; key++)
+    {
+        hash = (hash ^ static_cast<unsigned char>(*key)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+/**
+ * What AnyError needs to know about the type it holds, one static instance per type.
+ *
+ * Shared libraries built with hidden visibility each have their own instance, so the type is
+ * also identified by `type_key` and its hash.
+ */
+struct AnyErrorVtable
+{
+    std::string (*display)(const void* buf);
+    void (*throw_as_exception)(const void* buf);
+    /**
+     * Move constructs the error in `src` into `dst` and destroys the one in `src`.
+     */
+    void (*relocate)(void* dst, void* src) noexcept;
+    void (*destroy)(void* buf) noexcept;
+    bool on_heap;
+    std::uint64_t type_hash;
+    const char* type_key;
+};
+
+/**
+ * The operations of an AnyError holding an E, which is kept in the inline buffer if `Inline` and
+ * on the heap otherwise, with only the pointer in the buffer.
+ */
+template <class E, bool Inline>
+struct AnyErrorOps
+{
+    static const E* get(const void* buf)
+    {
+        if constexpr (Inline)
+        {
+            return std::launder(static_cast<const E*>(buf));
+        }
+        else
+        {
+            return *static_cast<E* const*>(buf);
+        }
+    }
+
+    template <class... Args>
+    static void construct(void* buf, Args&&... args)
+    {
+        if constexpr (Inline)
+        {
+            ::new (buf) E(std::forward<Args>(args)...);
+        }
+        else
+        {
+            ::new (buf) E*(new E(std::forward<Args>(args)...));
+        }
+    }
+
+    static std::string display(const void* buf)
+    {
+        return std::string(error_traits<E>::display(*get(buf)));
+    }
+
+    static void throw_as_exception(const void* buf)
+    {
+        error_traits<E>::throw_as_exception(*get(buf));
+    }
+
+    static void relocate(void* dst, void* src) noexcept
+    {
+        if constexpr (Inline)
+        {
+            E* e = std::launder(static_cast<E*>(src));
+            ::new (dst) E(std::move(*e));
+            e->~E();
+        }
+        else
+        {
+            ::new (dst) E*(*static_cast<E**>(src));
+        }
+    }
+
+    static void destroy(void* buf) noexcept
+    {
+        if constexpr (Inline)
+        {
+            std::launder(static_cast<E*>(buf))->~E();
+        }
+        else
+        {
+            delete *static_cast<E**>(buf);
+        }
+    }
+};
+
+} // namespace detail
+
+/**
+ *
+ * Error type that holds an error of any other error type, e.g. the bowl::Error subclasses of
+ * different layers or plugins, so they can be returned through a single Expected<T, AnyError>
+ * without slicing them.
+ *
+ * Errors of up to `inline_size` bytes with a noexcept move constructor are kept in an inline
+ * buffer, only larger ones are moved onto the heap. display() and throw_as_exception() are
+ * dispatched through a static table of function pointers for the held type, which is also how
+ * is<E>() tells the type: a single pointer comparison if the error was created in the same
+ * shared library. Libraries built with hidden visibility have tables of their own, so for errors
+ * from another library is<E>() compares a hash of the type's name, and the name itself if the
+ * hashes match.
+ *
+ * Every error type converts implicitly to AnyError, so CHECK_ASSIGN and BOWL_TRY wrap errors
+ * into it when they propagate them out of a function returning an AnyError.
+ *
+ * AnyError can be moved but not copied. A moved-from AnyError holds nothing and may only be
+ * destroyed or assigned to.
+ */
+class AnyError
+{
+public:
+    static constexpr std::size_t inline_size = 48;
+
+    /**
+     * True if an E is kept in the inline buffer.
+     */
+    template <class E>
+    static constexpr bool is_inline_v = sizeof(E) <= inline_size &&
+                                        alignof(E) <= alignof(void*) &&
+                                        std::is_nothrow_move_constructible_v<E>;
+
+    template <class E, class D = std::decay_t<E>,
+              std::enable_if_t<!std::is_same_v<D, AnyError> && is_error_v<D>, int> = 0>
+    AnyError(E&& err) : vtable_(&vtable_for<D>)
+    {
+        detail::AnyErrorOps<D, is_inline_v<D>>::construct(buffer_, std::forward<E>(err));
+    }
+
+    /**
+     * Constructs an E in place from `args`.
+     */
+    template <class E, class... Args>
+    AnyError(std::in_place_type_t<E>, Args&&... args) : vtable_(&vtable_for<E>)
+    {
+        static_assert(is_error_v<E>, "AnyError can only hold error types");
+
+        detail::AnyErrorOps<E, is_inline_v<E>>::construct(buffer_, std::forward<Args>(args)...);
+    }
+
+    AnyError(AnyError&& other) noexcept : vtable_(other.vtable_)
+    {
+        if (vtable_ != nullptr)
+        {
+            vtable_->relocate(buffer_, other.buffer_);
+            other.vtable_ = nullptr;
+        }
+    }
+
+    AnyError& operator=(AnyError&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+
+            if (other.vtable_ != nullptr)
+            {
+                other.vtable_->relocate(buffer_, other.buffer_);
+                vtable_ = other.vtable_;
+                other.vtable_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    AnyError(const AnyError&) = delete;
+    AnyError& operator=(const AnyError&) = delete;
+
+    ~AnyError()
+    {
+        reset();
+    }
+
+    std::string display() const
+    {
+        return vtable_->display(buffer_);
+    }
+
+    [[noreturn]] void throw_as_exception() const
+    {
+        vtable_->throw_as_exception(buffer_);
+        detail::abort_with("throw_as_exception() of the error in an AnyError returned");
+    }
+
+    /**
+     * True if the held error is exactly of type E.
+     */
+    template <class E>
+    bool is() const
+    {
+        if (BOWL_LIKELY(vtable_ == &vtable_for<E>))
+        {
+            return true;
+        }
+        return vtable_ != nullptr && vtable_->type_hash == vtable_for<E>.type_hash &&
+               std::strcmp(vtable_->type_key, vtable_for<E>.type_key) == 0;
+    }
+
+    /**
+     * The held error if it is exactly of type E, nullptr otherwise.
+     */
+    template <class E>
+    const E* as() const
+    {
+        return is<E>() ? detail::AnyErrorOps<E, is_inline_v<E>>::get(buffer_) : nullptr;
+    }
+
+    template <class E>
+    E* as()
+    {
+        return const_cast<E*>(static_cast<const AnyError&>(*this).as<E>());
+    }
+
+    /**
+     * True if the held error lives on the heap.
+     */
+    bool on_heap() const
+    {
+        return vtable_ != nullptr && vtable_->on_heap;
+    }
+
+private:
+    template <class E>
+    static constexpr detail::AnyErrorVtable vtable_for = {
+        &detail::AnyErrorOps<E, is_inline_v<E>>::display,
+        &detail::AnyErrorOps<E, is_inline_v<E>>::throw_as_exception,
+        &detail::AnyErrorOps<E, is_inline_v<E>>::relocate,
+        &detail::AnyErrorOps<E, is_inline_v<E>>::destroy,
+        !is_inline_v<E>,
+        detail::hash_type_key(detail::type_key<E>()),
+        detail::type_key<E>(),
+    };
+
+    void reset()
+    {
+        if (vtable_ != nullptr)
+        {
+            vtable_->destroy(buffer_);
+            vtable_ = nullptr;
+        }
+    }
+
+    alignas(void*) unsigned char buffer_[inline_size];
+    const detail::AnyErrorVtable* vtable_;
+};
+
+} // namespace bowl
@@ -0,0 +1,355 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <bowl/error.hpp>
+#include <bowl/exception.hpp>
+#include <bowl/niche.hpp>
+
+#include <atomic>
+#include <string>
+#include <type_traits>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace bowl
+{
+
+/**
+ *
+ * An entry of the error catalog, registered with BOWL_CATALOG_ERROR.
+ */
+struct CatalogEntry
+{
+    std::uint32_t id;
+    const char* name;
+    const char* category;
+    /**
+     * Message with `{}` placeholders for the parameters, see FormattedError.
+     */
+    const char* message;
+    const CatalogEntry* next;
+};
+
+namespace detail
+{
+
+inline std::atomic<const CatalogEntry*> catalog_head{ nullptr };
+
+/**
+ * Prepends an entry to the catalog during static initialization. Registering two different
+ * entries with the same id is a programming error and aborts.
+ */
+struct CatalogRegistrar
+{
+    explicit CatalogRegistrar(CatalogEntry& entry)
+    {
+        const CatalogEntry* head = catalog_head.load(std::memory_order_acquire);
+
+        for (const CatalogEntry* it = head; it != nullptr; it = it->next)
+        {
+            if (it->id == entry.id)
+            {
+                abort_with("two error catalog entries have the same id");
+            }
+        }
+
+        do
+        {
+            entry.next = head;
+        } while (!catalog_head.compare_exchange_weak(head, &entry, std::memory_order_release,
+                                                     std::memory_order_acquire));
+    }
+};
+
+/**
+ * True if a parameter of type P is an unsigned 32-bit integer, whose values above INT32_MAX do not
+ * survive being stored as an std::int32_t. Enums count as their underlying type.
+ */
+template <class P, bool = std::is_enum_v<P>>
+constexpr bool is_unsigned_param_v =
+    std::is_unsigned_v<P> && sizeof(P) == sizeof(std::int32_t);
+
+template <class P>
+constexpr bool is_unsigned_param_v<P, true> = is_unsigned_param_v<std::underlying_type_t<P>>;
+
+} // namespace detail
+
+/**
+ *
+ * The first entry of the error catalog, in no particular order. Follow `next` for the others.
+ */
+inline const CatalogEntry* catalog()
+{
+    return detail::catalog_head.load(std::memory_order_acquire);
+}
+
+/**
+ *
+ * The catalog entry with the given id, or nullptr.
+ */
+inline const CatalogEntry* catalog_find(std::uint32_t id)
+{
+    for (const CatalogEntry* it = catalog(); it != nullptr; it = it->next)
+    {
+        if (it->id == id)
+        {
+            return it;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ *
+ * Error type which is nothing but the id of an error catalog entry and up to `max_params` small
+ * integer parameters. The message of the entry is only looked up and formatted on display().
+ *
+ *     BOWL_CATALOG_ERROR(QueueFull, 0x0101, "queue", "queue {} is full ({} entries)");
+ *
+ *     bowl::MaybeError<bowl::CatalogError> push(int queue)
+ *     {
+ *         ...
+ *         return bowl::Unexpected(bowl::CatalogError(QueueFull{}, queue, size));
+ *     }
+ *
+ * A CatalogError is 16 bytes and trivially copyable. The id shares a word with one bit per
+ * parameter, which is set for unsigned 32-bit parameters, so they are displayed and returned by
+ * param() with their original value. Ids of `max_id` and above are never registered, so words
+ * of `niche_word` and above are free to be used as niches. So MaybeError<CatalogError> and
+ * Expected<T, CatalogError> with T of up to 12 bytes are 16 bytes, which are returned in two
+ * registers.
+ */
+class CatalogError
+{
+    static constexpr unsigned id_bits = 29;
+    static constexpr std::uint32_t id_mask = (std::uint32_t(1) << id_bits) - 1;
+
+public:
+    static constexpr std::size_t max_params = 3;
+    static constexpr std::uint32_t max_id = 0x1ffff000;
+    /**
+     * The smallest word of id and unsigned bits that is a niche.
+     */
+    static constexpr std::uint32_t niche_word = 0xfffff000;
+
+    template <class Kind, class... Params>
+    CatalogError(Kind, Params... params)
+    : params_{ static_cast<std::int32_t>(params)... },
+      id_(Kind::catalog_id | unsigned_bits<Params...>())
+    {
+        static_assert(sizeof...(Params) <= max_params,
+                      "CatalogError takes at most max_params parameters");
+        static_assert(((std::is_integral_v<Params> || std::is_enum_v<Params>) && ...),
+                      "parameters of CatalogError have to be integers or enums");
+        static_assert(((sizeof(Params) <= sizeof(std::int32_t)) && ...),
+                      "parameters of CatalogError have to fit into 32 bits");
+    }
+
+    std::uint32_t id() const
+    {
+        return id_ & id_mask;
+    }
+
+    /**
+     * The parameter `i` as it was passed, which may be an unsigned 32-bit value.
+     */
+    std::int64_t param(std::size_t i) const
+    {
+        if (id_ & (std::uint32_t(1) << (id_bits + i)))
+        {
+            return static_cast<std::uint32_t>(params_[i]);
+        }
+        return params_[i];
+    }
+
+    /**
+     * The catalog entry of this error, or nullptr if its id was never registered.
+     */
+    const CatalogEntry* entry() const
+    {
+        return catalog_find(id());
+    }
+
+    /**
+     * The message of the catalog entry with the parameters filled in.
+     */
+    std::string display() const
+    {
+        const CatalogEntry* e = entry();
+
+        if (BOWL_UNLIKELY(e == nullptr))
+        {
+            return FormattedError("unknown error catalog id {}", id()).display();
+        }
+        return FormattedError(e->message, param(0), param(1), param(2)).display();
+    }
+
+    [[noreturn]] void throw_as_exception() const;
+
+private:
+    template <class... Params>
+    static constexpr std::uint32_t unsigned_bits()
+    {
+        constexpr bool is_unsigned[] = { detail::is_unsigned_param_v<Params>..., false };
+        std::uint32_t bits = 0;
+
+        for (std::size_t i = 0; i < sizeof...(Params); i++)
+        {
+            if (is_unsigned[i])
+            {
+                bits |= std::uint32_t(1) << (id_bits + i);
+            }
+        }
+        return bits;
+    }
+
+    std::int32_t params_[max_params];
+    std::uint32_t id_;
+};
+
+/**
+ *
+ * Words of id and unsigned bits of `CatalogError::niche_word` and above have an id of `max_id` or
+ * above, which is never registered, so they are the niches of CatalogError. The id is the last
+ * member, so the niches do not overlap small success objects.
+ */
+template <>
+struct niche_traits<CatalogError>
+{
+    static constexpr std::size_t count = 0x100000000 - CatalogError::niche_word;
+    static constexpr std::size_t offset = CatalogError::max_params * sizeof(std::int32_t);
+
+    static void store(void* x, std::size_t n)
+    {
+        std::uint32_t val = CatalogError::niche_word + static_cast<std::uint32_t>(n);
+        std::memcpy(static_cast<char*>(x) + offset, &val, sizeof(val));
+    }
+
+    static std::size_t load(const void* x)
+    {
+        std::uint32_t val;
+        std::memcpy(&val, static_cast<const char*>(x) + offset, sizeof(val));
+
+        return val >= CatalogError::niche_word ? val - CatalogError::niche_word : count;
+    }
+};
+
+/**
+ *
+ * Corresponding exception type to CatalogError. The message is formatted when the exception is
+ * thrown, and it can also be caught as a CustomException.
+ */
+class CatalogException : public CustomException
+{
+public:
+    CatalogException(const CatalogError& err)
+    : CustomException(CustomError(err.display())), catalog_(err)
+    {
+    }
+
+    const CatalogError& catalog_error() const
+    {
+        return catalog_;
+    }
+
+protected:
+    CatalogError catalog_;
+};
+
+inline void CatalogError::throw_as_exception() const
+{
+    detail::throw_exception(CatalogException(*this));
+}
+
+namespace detail
+{
+
+inline void write_json_string(std::FILE* out, const char* str)
+{
+    std::fputc('"', out);
+    for (; *str != '\0'; str++)
+    {
+        unsigned char c = static_cast<unsigned char>(*str);
+
+        if (c == '"' || c == '\\')
+        {
+            std::fprintf(out, "\\%c", c);
+        }
+        else if (c < 0x20)
+        {
+            std::fprintf(out, "\\u%04x", c);
+        }
+        else
+        {
+            std::fputc(c, out);
+        }
+    }
+    std::fputc('"', out);
+}
+
+} // namespace detail
+
+/**
+ *
+ * Writes every entry of the error catalog to `out`, one JSON object per line and sorted by id:
+ *
+ *     {"id":257,"name":"QueueFull","category":"queue","message":"queue {} is full ({} entries)"}
+ *
+ * A log pipeline that ships CatalogError ids and parameters can turn them back into messages
+ * with this table. Call it from a command line flag of the program that registers the errors.
+ */
+inline void dump_catalog(std::FILE* out)
+{
+    const CatalogEntry* last = nullptr;
+
+    while (true)
+    {
+        const CatalogEntry* next = nullptr;
+
+        for (const CatalogEntry* it = catalog(); it != nullptr; it = it->next)
+        {
+            if ((last == nullptr || it->id > last->id) && (next == nullptr || it->id < next->id))
+            {
+                next = it;
+            }
+        }
+
+        if (next == nullptr)
+        {
+            return;
+        }
+
+        std::fprintf(out, "{\"id\":%u,\"name\":", static_cast<unsigned>(next->id));
+        detail::write_json_string(out, next->name);
+        std::fputs(",\"category\":", out);
+        detail::write_json_string(out, next->category);
+        std::fputs(",\"message\":", out);
+        detail::write_json_string(out, next->message);
+        std::fputs("}\n", out);
+
+        last = next;
+    }
+}
+
+} // namespace bowl
+
+/**
+ *
+ * Registers an error catalog entry and defines the tag type `name` to create CatalogErrors of it.
+ * Use it at namespace scope, typically in a header. `id` has to be a constant below
+ * CatalogError::max_id which is unique within the program, and should never change once it has
+ * been shipped.
+ */
+#define BOWL_CATALOG_ERROR(name, id, category, message)                                            \
+    struct name                                                                                    \
+    {                                                                                              \
+        static_assert((id) < bowl::CatalogError::max_id, "catalog ids must be below max_id");      \
+                                                                                                   \
+        static constexpr std::uint32_t catalog_id = (id);                                          \
+    };                                                                                             \
+                                                                                                   \
+    inline bowl::CatalogEntry name##_catalog_entry_{ (id), #name, category, message, nullptr };    \
+    inline const bowl::detail::CatalogRegistrar name##_catalog_registrar_{ name##_catalog_entry_ }
@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+/**
+ * BOWL_NO_EXCEPTIONS: build bowl without using `throw`.
+ *
+ * Defined automatically if the compiler has exceptions disabled (-fno-exceptions).
+ * Every place that would throw prints the message of the exception instead and aborts.
+ */
+#if !defined(BOWL_NO_EXCEPTIONS) && !defined(__cpp_exceptions) && !defined(__EXCEPTIONS)
+#define BOWL_NO_EXCEPTIONS
+#endif
+
+/**
+ * BOWL_LIKELY(x), BOWL_UNLIKELY(x): branch hints for the success and the error path.
+ *
+ * BOWL_COLD: keeps a function out of line and moves it into .text.unlikely, for error paths
+ * which would otherwise be inlined into every caller.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define BOWL_LIKELY(x) __builtin_expect(!!(x), 1)
+#define BOWL_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#define BOWL_COLD __attribute__((cold, noinline))
+#else
+#define BOWL_LIKELY(x) (x)
+#define BOWL_UNLIKELY(x) (x)
+#define BOWL_COLD
+#endif
+
+/**
+ * BOWL_HAS_STATEMENT_EXPRESSIONS: defined if the compiler supports GNU statement expressions
+ * `({ ... })`, which BOWL_TRY() needs.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define BOWL_HAS_STATEMENT_EXPRESSIONS
+#endif
+
+/**
+ * BOWL_CONTEXT_ARENA_SIZE: bytes per thread for the frames added by with_context(), see
+ * bowl/context.hpp. Frames that do not fit are dropped and counted, never allocated.
+ */
+#ifndef BOWL_CONTEXT_ARENA_SIZE
+#define BOWL_CONTEXT_ARENA_SIZE 8192
+#endif
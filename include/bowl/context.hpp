@@ -0,0 +1,432 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <bowl/config.hpp>
+#include <bowl/error.hpp>
+#include <bowl/expected.hpp>
+#include <bowl/maybe_error.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace bowl
+{
+
+namespace detail
+{
+
+/**
+ * A frame of context, kept in the ContextArena of the thread that added it. `prev` is the handle
+ * of the frame added before, 0 for none.
+ */
+struct ContextFrame
+{
+    FormattedError message;
+    std::uint32_t prev;
+};
+
+/**
+ * Bump allocator for context frames and the strings they refer to. Every thread owns one, and
+ * only the owner allocates from it.
+ *
+ * It counts the Contextual errors with frames in it, and starts over once the last of them is
+ * gone, which is when the root error has been consumed. The count is atomic, as a Contextual may
+ * be destroyed on another thread. The reset is always done by the owner: right away if the last
+ * Contextual dies on the owner thread, or else when the owner creates the next one. Allocations
+ * that do not fit into the BOWL_CONTEXT_ARENA_SIZE bytes fail, they never fall back to the heap.
+ *
+ * Arenas are never freed, as a Contextual can outlive the thread that added its frames. When a
+ * thread exits, its arena goes back to a pool and is handed to the next new thread.
+ */
+class ContextArena
+{
+public:
+    /**
+     * The arena owned by the calling thread, taken from the pool or allocated on first use.
+     */
+    static ContextArena& local();
+
+    /**
+     * The arena owned by the calling thread, or nullptr if it has none yet.
+     */
+    static ContextArena* owned()
+    {
+        return owned_;
+    }
+
+    void* allocate(std::size_t size, std::size_t align)
+    {
+        std::size_t start = (used_ + align - 1) & ~(align - 1);
+
+        if (start > sizeof(bytes_) || size > sizeof(bytes_) - start)
+        {
+            return nullptr;
+        }
+
+        used_ = start + size;
+        return bytes_ + start;
+    }
+
+    std::uint32_t handle(const ContextFrame* frame) const
+    {
+        return static_cast<std::uint32_t>(reinterpret_cast<const unsigned char*>(frame) - bytes_) +
+               1;
+    }
+
+    const ContextFrame& frame(std::uint32_t handle) const
+    {
+        return *std::launder(reinterpret_cast<const ContextFrame*>(bytes_ + handle - 1));
+    }
+
+    /**
+     * A Contextual refers to this arena. Only the owner thread can find the count at 0, other
+     * threads only acquire for copies of a Contextual which still refers to the arena.
+     */
+    void acquire()
+    {
+        if (live_.fetch_add(1, std::memory_order_acq_rel) == 0)
+        {
+            used_ = 0;
+        }
+    }
+
+    /**
+     * A Contextual no longer refers to this arena. May be called on any thread.
+     */
+    void release()
+    {
+        if (live_.fetch_sub(1, std::memory_order_acq_rel) == 1 && owned_ == this)
+        {
+            used_ = 0;
+        }
+    }
+
+    /**
+     * Bytes currently in use.
+     */
+    std::size_t used() const
+    {
+        return used_;
+    }
+
+private:
+    friend class ContextArenaLease;
+
+    static inline thread_local ContextArena* owned_ = nullptr;
+
+    alignas(ContextFrame) unsigned char bytes_[BOWL_CONTEXT_ARENA_SIZE] = {};
+    std::size_t used_ = 0;
+    std::atomic<std::size_t> live_{ 0 };
+    ContextArena* next_free_ = nullptr;
+};
+
+/**
+ * Arenas of exited threads, ready to be handed to new ones.
+ */
+struct ContextArenaPool
+{
+    std::mutex mutex;
+    ContextArena* free = nullptr;
+};
+
+inline ContextArenaPool context_arena_pool;
+
+/**
+ * Holds the arena of a thread from its first use until the thread exits.
+ */
+class ContextArenaLease
+{
+public:
+    ContextArenaLease()
+    {
+        {
+            std::lock_guard<std::mutex> lock(context_arena_pool.mutex);
+
+            arena_ = context_arena_pool.free;
+            if (arena_ != nullptr)
+            {
+                context_arena_pool.free = arena_->next_free_;
+            }
+        }
+
+        if (arena_ == nullptr)
+        {
+            arena_ = new ContextArena;
+        }
+        ContextArena::owned_ = arena_;
+    }
+
+    ~ContextArenaLease()
+    {
+        ContextArena::owned_ = nullptr;
+
+        std::lock_guard<std::mutex> lock(context_arena_pool.mutex);
+        arena_->next_free_ = context_arena_pool.free;
+        context_arena_pool.free = arena_;
+    }
+
+    ContextArenaLease(const ContextArenaLease&) = delete;
+    ContextArenaLease& operator=(const ContextArenaLease&) = delete;
+
+    ContextArena& arena() const
+    {
+        return *arena_;
+    }
+
+private:
+    ContextArena* arena_;
+};
+
+inline ContextArena& ContextArena::local()
+{
+    thread_local ContextArenaLease lease;
+    return lease.arena();
+}
+
+/**
+ * Copies `str` into the arena, so a context frame does not depend on the lifetime of the
+ * caller's strings. Clears `fits` if there is no room left.
+ */
+inline const char* stash_context_string(ContextArena& arena, std::string_view str, bool& fits)
+{
+    char* copy = static_cast<char*>(arena.allocate(str.size() + 1, 1));
+
+    if (copy == nullptr)
+    {
+        fits = false;
+        return "";
+    }
+
+    std::memcpy(copy, str.data(), str.size());
+    copy[str.size()] = '\0';
+    return copy;
+}
+
+/**
+ * Turns an argument of with_context() into one of FormattedError: strings are copied into the
+ * arena, everything else is captured as it is.
+ */
+template <class X>
+decltype(auto) stash_context_arg(ContextArena& arena, const X& x, bool& fits)
+{
+    if constexpr (std::is_convertible_v<const X&, const char*>)
+    {
+        const char* str = x;
+        return str != nullptr ? stash_context_string(arena, str, fits) : str;
+    }
+    else if constexpr (std::is_convertible_v<const X&, std::string_view>)
+    {
+        return stash_context_string(arena, std::string_view(x), fits);
+    }
+    else
+    {
+        return x;
+    }
+}
+
+} // namespace detail
+
+/**
+ *
+ * An error E with a chain of context frames, added by with_context() on the way up:
+ *
+ *     bowl::Expected<Config, bowl::Contextual<bowl::ErrnoError>> load_config(const char* path)
+ *     {
+ *         CHECK_ASSIGN(fd, bowl::sys::open(path, O_RDONLY).with_context("opening {}", path));
+ *         ...
+ *     }
+ *
+ *     load_config(path).with_context("loading config for {}", user)
+ *     // display(): "loading config for alice: opening /etc/app.conf: No such file or directory"
+ *
+ * A frame is a FormattedError, copied into the ContextArena of the thread together with its
+ * string arguments, and the error only keeps the arena and the handle of its newest frame. So
+ * adding context does not allocate, and formatting happens on display(). Frames that do not fit
+ * into the arena are dropped and counted.
+ *
+ * A Contextual can be passed to and destroyed on other threads, but only the thread that created
+ * it can add frames to it: context added on another thread is dropped and counted as well.
+ * While a Contextual is alive, its arena is not reset, so do not keep errors with context around
+ * for long: frames added meanwhile on that thread only fit into the space left.
+ */
+template <class E>
+class Contextual
+{
+public:
+    Contextual(E err) : err_(std::move(err)), arena_(&detail::ContextArena::local())
+    {
+        arena_->acquire();
+    }
+
+    Contextual(const Contextual& other)
+    : err_(other.err_), arena_(other.arena_), head_(other.head_), dropped_(other.dropped_)
+    {
+        arena_->acquire();
+    }
+
+    Contextual(Contextual&& other) noexcept(std::is_nothrow_move_constructible_v<E>)
+    : err_(std::move(other.err_)), arena_(other.arena_), head_(other.head_),
+      dropped_(other.dropped_)
+    {
+        arena_->acquire();
+    }
+
+    Contextual& operator=(const Contextual& other)
+    {
+        err_ = other.err_;
+        assign_frames(other);
+        return *this;
+    }
+
+    Contextual& operator=(Contextual&& other) noexcept(std::is_nothrow_move_assignable_v<E>)
+    {
+        err_ = std::move(other.err_);
+        assign_frames(other);
+        return *this;
+    }
+
+    ~Contextual()
+    {
+        arena_->release();
+    }
+
+    /**
+     * Adds a frame with the message `fmt`, whose `{}` are replaced by `args` as by
+     * FormattedError. Strings can also be passed as std::string or std::string_view.
+     */
+    template <class... Args>
+    void add_context(const char* fmt, const Args&... args)
+    {
+        if (BOWL_UNLIKELY(arena_ != detail::ContextArena::owned()))
+        {
+            dropped_++;
+            return;
+        }
+
+        bool fits = true;
+        FormattedError message(fmt, detail::stash_context_arg(*arena_, args, fits)...);
+
+        void* mem =
+            fits ? arena_->allocate(sizeof(detail::ContextFrame), alignof(detail::ContextFrame))
+                 : nullptr;
+
+        if (BOWL_UNLIKELY(mem == nullptr))
+        {
+            dropped_++;
+            return;
+        }
+
+        head_ = arena_->handle(::new (mem) detail::ContextFrame{ message, head_ });
+    }
+
+    /**
+     * The error without its context.
+     */
+    const E& error() const
+    {
+        return err_;
+    }
+
+    E& error()
+    {
+        return err_;
+    }
+
+    /**
+     * The frames from the newest to the oldest, then the error, separated by ": ".
+     */
+    std::string display() const
+    {
+        std::string msg;
+
+        for (std::uint32_t handle = head_; handle != 0;)
+        {
+            const detail::ContextFrame& frame = arena_->frame(handle);
+
+            msg += frame.message.display();
+            msg += ": ";
+            handle = frame.prev;
+        }
+
+        msg += error_traits<E>::display(err_);
+
+        if (dropped_ > 0)
+        {
+            msg += FormattedError(" ({} context frames dropped)", dropped_).display();
+        }
+        return msg;
+    }
+
+    /**
+     * Throws a CustomException with the message of display().
+     */
+    [[noreturn]] void throw_as_exception() const
+    {
+        detail::throw_exception(CustomException(CustomError(display())));
+    }
+
+private:
+    void assign_frames(const Contextual& other)
+    {
+        other.arena_->acquire();
+        arena_->release();
+        arena_ = other.arena_;
+        head_ = other.head_;
+        dropped_ = other.dropped_;
+    }
+
+    E err_;
+    detail::ContextArena* arena_;
+    std::uint32_t head_ = 0;
+    std::uint32_t dropped_ = 0;
+};
+
+namespace detail
+{
+
+template <class E>
+Contextual<E> to_contextual(E&& err)
+{
+    return Contextual<E>(std::move(err));
+}
+
+template <class E>
+Contextual<E> to_contextual(Contextual<E>&& err)
+{
+    return std::move(err);
+}
+
+} // namespace detail
+
+template <class T, class E, class Policy>
+template <class... Args>
+auto Expected<T, E, Policy>::with_context(const char* fmt, const Args&... args) &&
+{
+    return std::move(*this).map_error([&](auto&& err) {
+        auto ctx = detail::to_contextual(std::forward<decltype(err)>(err));
+        ctx.add_context(fmt, args...);
+        return ctx;
+    });
+}
+
+template <class E, class Policy>
+template <class... Args>
+auto MaybeError<E, Policy>::with_context(const char* fmt, const Args&... args) &&
+{
+    return std::move(*this).map_error([&](auto&& err) {
+        auto ctx = detail::to_contextual(std::forward<decltype(err)>(err));
+        ctx.add_context(fmt, args...);
+        return ctx;
+    });
+}
+
+} // namespace bowl
@@ -0,0 +1,246 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <array>
+#include <string_view>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+
+namespace bowl
+{
+
+/**
+ * All Linux errnos as X(Name, ENAME, "description"), with the descriptions of glibc's strerror().
+ *
+ * The aliases EWOULDBLOCK and EDEADLOCK come after the errnos they alias.
+ */
+#define BOWL_ERRNO_LIST(X)                                                                         \
+    X(NOMEM, ENOMEM, "Cannot allocate memory")                                                     \
+    X(PERM, EPERM, "Operation not permitted")                                                      \
+    X(NOENT, ENOENT, "No such file or directory")                                                  \
+    X(SRCH, ESRCH, "No such process")                                                              \
+    X(INTR, EINTR, "Interrupted system call")                                                      \
+    X(IO, EIO, "Input/output error")                                                               \
+    X(NXIO, ENXIO, "No such device or address")                                                    \
+    X(TOOBIG, E2BIG, "Argument list too long")                                                     \
+    X(NOEXEC, ENOEXEC, "Exec format error")                                                        \
+    X(BADF, EBADF, "Bad file descriptor")                                                          \
+    X(CHILD, ECHILD, "No child processes")                                                         \
+    X(AGAIN, EAGAIN, "Resource temporarily unavailable")                                           \
+    X(ACCES, EACCES, "Permission denied")                                                          \
+    X(FAULT, EFAULT, "Bad address")                                                                \
+    X(NOTBLK, ENOTBLK, "Block device required")                                                    \
+    X(BUSY, EBUSY, "Device or resource busy")                                                      \
+    X(EXIST, EEXIST, "File exists")                                                                \
+    X(XDEV, EXDEV, "Invalid cross-device link")                                                    \
+    X(NODEV, ENODEV, "No such device")                                                             \
+    X(NOTDIR, ENOTDIR, "Not a directory")                                                          \
+    X(ISDIR, EISDIR, "Is a directory")                                                             \
+    X(INVAL, EINVAL, "Invalid argument")                                                           \
+    X(NFILE, ENFILE, "Too many open files in system")                                              \
+    X(MFILE, EMFILE, "Too many open files")                                                        \
+    X(NOTTY, ENOTTY, "Inappropriate ioctl for device")                                             \
+    X(TXTBSY, ETXTBSY, "Text file busy")                                                           \
+    X(FBIG, EFBIG, "File too large")                                                               \
+    X(NOSPC, ENOSPC, "No space left on device")                                                    \
+    X(SPIPE, ESPIPE, "Illegal seek")                                                               \
+    X(ROFS, EROFS, "Read-only file system")                                                        \
+    X(MLINK, EMLINK, "Too many links")                                                             \
+    X(PIPE, EPIPE, "Broken pipe")                                                                  \
+    X(DOM, EDOM, "Numerical argument out of domain")                                               \
+    X(RANGE, ERANGE, "Numerical result out of range")                                              \
+    X(DEADLK, EDEADLK, "Resource deadlock avoided")                                                \
+    X(NAMETOOLONG, ENAMETOOLONG, "File name too long")                                             \
+    X(NOLCK, ENOLCK, "No locks available")                                                         \
+    X(NOSYS, ENOSYS, "Function not implemented")                                                   \
+    X(NOTEMPTY, ENOTEMPTY, "Directory not empty")                                                  \
+    X(LOOP, ELOOP, "Too many levels of symbolic links")                                            \
+    X(WOULDBLOCK, EWOULDBLOCK, "Resource temporarily unavailable")                                 \
+    X(NOMSG, ENOMSG, "No message of desired type")                                                 \
+    X(IDRM, EIDRM, "Identifier removed")                                                           \
+    X(CHRNG, ECHRNG, "Channel number out of range")                                                \
+    X(L2NSYNC, EL2NSYNC, "Level 2 not synchronized")                                               \
+    X(L3HLT, EL3HLT, "Level 3 halted")                                                             \
+    X(L3RST, EL3RST, "Level 3 reset")                                                              \
+    X(LNRNG, ELNRNG, "Link number out of range")                                                   \
+    X(UNATCH, EUNATCH, "Protocol driver not attached")                                             \
+    X(NOCSI, ENOCSI, "No CSI structure available")                                                 \
+    X(L2HLT, EL2HLT, "Level 2 halted")                                                             \
+    X(BADE, EBADE, "Invalid exchange")                                                             \
+    X(BADR, EBADR, "Invalid request descriptor")                                                   \
+    X(XFULL, EXFULL, "Exchange full")                                                              \
+    X(NOANO, ENOANO, "No anode")                                                                   \
+    X(BADRQC, EBADRQC, "Invalid request code")                                                     \
+    X(BADSLT, EBADSLT, "Invalid slot")                                                             \
+    X(DEADLOCK, EDEADLOCK, "Resource deadlock avoided")                                            \
+    X(BFONT, EBFONT, "Bad font file format")                                                       \
+    X(NOSTR, ENOSTR, "Device not a stream")                                                        \
+    X(NODATA, ENODATA, "No data available")                                                        \
+    X(TIME, ETIME, "Timer expired")                                                                \
+    X(NOSR, ENOSR, "Out of streams resources")                                                     \
+    X(NONET, ENONET, "Machine is not on the network")                                              \
+    X(NOPKG, ENOPKG, "Package not installed")                                                      \
+    X(REMOTE, EREMOTE, "Object is remote")                                                         \
+    X(NOLINK, ENOLINK, "Link has been severed")                                                    \
+    X(ADV, EADV, "Advertise error")                                                                \
+    X(SRMNT, ESRMNT, "Srmount error")                                                              \
+    X(COMM, ECOMM, "Communication error on send")                                                  \
+    X(PROTO, EPROTO, "Protocol error")                                                             \
+    X(MULTIHOP, EMULTIHOP, "Multihop attempted")                                                   \
+    X(DOTDOT, EDOTDOT, "RFS specific error")                                                       \
+    X(BADMSG, EBADMSG, "Bad message")                                                              \
+    X(OVERFLOW, EOVERFLOW, "Value too large for defined data type")                                \
+    X(NOTUNIQ, ENOTUNIQ, "Name not unique on network")                                             \
+    X(BADFD, EBADFD, "File descriptor in bad state")                                               \
+    X(REMCHG, EREMCHG, "Remote address changed")                                                   \
+    X(LIBACC, ELIBACC, "Can not access a needed shared library")                                   \
+    X(LIBBAD, ELIBBAD, "Accessing a corrupted shared library")                                     \
+    X(LIBSCN, ELIBSCN, ".lib section in a.out corrupted")                                          \
+    X(LIBMAX, ELIBMAX, "Attempting to link in too many shared libraries")                          \
+    X(LIBEXEC, ELIBEXEC, "Cannot exec a shared library directly")                                  \
+    X(ILSEQ, EILSEQ, "Invalid or incomplete multibyte or wide character")                          \
+    X(RESTART, ERESTART, "Interrupted system call should be restarted")                            \
+    X(STRPIPE, ESTRPIPE, "Streams pipe error")                                                     \
+    X(USERS, EUSERS, "Too many users")                                                             \
+    X(NOTSOCK, ENOTSOCK, "Socket operation on non-socket")                                         \
+    X(DESTADDRREQ, EDESTADDRREQ, "Destination address required")                                   \
+    X(MSGSIZE, EMSGSIZE, "Message too long")                                                       \
+    X(PROTOTYPE, EPROTOTYPE, "Protocol wrong type for socket")                                     \
+    X(NOPROTOOPT, ENOPROTOOPT, "Protocol not available")                                           \
+    X(PROTONOSUPPORT, EPROTONOSUPPORT, "Protocol not supported")                                   \
+    X(SOCKTNOSUPPORT, ESOCKTNOSUPPORT, "Socket type not supported")                                \
+    X(OPNOTSUPP, EOPNOTSUPP, "Operation not supported")                                            \
+    X(PFNOSUPPORT, EPFNOSUPPORT, "Protocol family not supported")                                  \
+    X(AFNOSUPPORT, EAFNOSUPPORT, "Address family not supported by protocol")                       \
+    X(ADDRINUSE, EADDRINUSE, "Address already in use")                                             \
+    X(ADDRNOTAVAIL, EADDRNOTAVAIL, "Cannot assign requested address")                              \
+    X(NETDOWN, ENETDOWN, "Network is down")                                                        \
+    X(NETUNREACH, ENETUNREACH, "Network is unreachable")                                           \
+    X(NETRESET, ENETRESET, "Network dropped connection on reset")                                  \
+    X(CONNABORTED, ECONNABORTED, "Software caused connection abort")                               \
+    X(CONNRESET, ECONNRESET, "Connection reset by peer")                                           \
+    X(NOBUFS, ENOBUFS, "No buffer space available")                                                \
+    X(ISCONN, EISCONN, "Transport endpoint is already connected")                                  \
+    X(NOTCONN, ENOTCONN, "Transport endpoint is not connected")                                    \
+    X(SHUTDOWN, ESHUTDOWN, "Cannot send after transport endpoint shutdown")                        \
+    X(TOOMANYREFS, ETOOMANYREFS, "Too many references: cannot splice")                             \
+    X(TIMEDOUT, ETIMEDOUT, "Connection timed out")                                                 \
+    X(CONNREFUSED, ECONNREFUSED, "Connection refused")                                             \
+    X(HOSTDOWN, EHOSTDOWN, "Host is down")                                                         \
+    X(HOSTUNREACH, EHOSTUNREACH, "No route to host")                                               \
+    X(ALREADY, EALREADY, "Operation already in progress")                                          \
+    X(INPROGRESS, EINPROGRESS, "Operation now in progress")                                        \
+    X(STALE, ESTALE, "Stale file handle")                                                          \
+    X(UCLEAN, EUCLEAN, "Structure needs cleaning")                                                 \
+    X(NOTNAM, ENOTNAM, "Not a XENIX named type file")                                              \
+    X(NAVAIL, ENAVAIL, "No XENIX semaphores available")                                            \
+    X(ISNAM, EISNAM, "Is a named type file")                                                       \
+    X(REMOTEIO, EREMOTEIO, "Remote I/O error")                                                     \
+    X(DQUOT, EDQUOT, "Disk quota exceeded")                                                        \
+    X(NOMEDIUM, ENOMEDIUM, "No medium found")                                                      \
+    X(MEDIUMTYPE, EMEDIUMTYPE, "Wrong medium type")                                                \
+    X(CANCELED, ECANCELED, "Operation canceled")                                                   \
+    X(NOKEY, ENOKEY, "Required key not available")                                                 \
+    X(KEYEXPIRED, EKEYEXPIRED, "Key has expired")                                                  \
+    X(KEYREVOKED, EKEYREVOKED, "Key has been revoked")                                             \
+    X(KEYREJECTED, EKEYREJECTED, "Key was rejected by service")                                    \
+    X(OWNERDEAD, EOWNERDEAD, "Owner died")                                                         \
+    X(NOTRECOVERABLE, ENOTRECOVERABLE, "State not recoverable")                                    \
+    X(RFKILL, ERFKILL, "Operation not possible due to RF-kill")                                    \
+    X(HWPOISON, EHWPOISON, "Memory page has hardware error")
+
+/**
+ * Type-safe enum for all Linux errno #defines
+ */
+enum class Errno : int
+{
+#define BOWL_ERRNO_ENUM(id, value, text) id = value,
+    BOWL_ERRNO_LIST(BOWL_ERRNO_ENUM)
+#undef BOWL_ERRNO_ENUM
+};
+
+/**
+ *
+ * Symbolic name and description of an errno. Both point to string literals, so they are valid
+ * for the whole program and NUL-terminated.
+ */
+struct ErrnoInfo
+{
+    std::string_view name;
+    std::string_view description;
+};
+
+namespace detail
+{
+
+constexpr std::size_t errno_table_size()
+{
+    int max = 0;
+#define BOWL_ERRNO_MAX(id, value, text) max = value > max ? value : max;
+    BOWL_ERRNO_LIST(BOWL_ERRNO_MAX)
+#undef BOWL_ERRNO_MAX
+    return static_cast<std::size_t>(max) + 1;
+}
+
+using ErrnoTable = std::array<ErrnoInfo, errno_table_size()>;
+
+/**
+ * Table indexed by errno value. Aliases do not overwrite the entry of the errno they alias.
+ */
+constexpr ErrnoTable make_errno_table()
+{
+    ErrnoTable table{};
+#define BOWL_ERRNO_ENTRY(id, value, text)                                                          \
+    if (table[value].name.empty())                                                                 \
+    {                                                                                              \
+        table[value] = { #value, text };                                                           \
+    }
+    BOWL_ERRNO_LIST(BOWL_ERRNO_ENTRY)
+#undef BOWL_ERRNO_ENTRY
+    return table;
+}
+
+inline constexpr ErrnoTable errno_table = make_errno_table();
+
+} // namespace detail
+
+/**
+ *
+ * Look up the name and description of an errno, without strerror(), so it is thread-safe and
+ * does not allocate. Values which are no known errno give an empty name and "Unknown error".
+ */
+constexpr ErrnoInfo errno_info(Errno err)
+{
+    auto idx = static_cast<std::size_t>(static_cast<unsigned int>(err));
+
+    if (idx < detail::errno_table.size() && !detail::errno_table[idx].name.empty())
+    {
+        return detail::errno_table[idx];
+    }
+    return { {}, "Unknown error" };
+}
+
+/**
+ *
+ * Writes the description of `err` into `buf`, truncating it to `size - 1` characters and
+ * always NUL-terminating it if `size > 0`, just like snprintf().
+ *
+ * Returns the length of the complete description, without the NUL.
+ */
+inline std::size_t errno_display_to(Errno err, char* buf, std::size_t size)
+{
+    std::string_view desc = errno_info(err).description;
+
+    if (size > 0)
+    {
+        std::size_t n = desc.size() < size - 1 ? desc.size() : size - 1;
+        std::memcpy(buf, desc.data(), n);
+        buf[n] = '\0';
+    }
+    return desc.size();
+}
+
+} // namespace bowl
@@ -2,161 +2,71 @@
 
 #pragma once
 
+#include <bowl/errno.hpp>
+#include <bowl/error_traits.hpp>
+#include <bowl/exception.hpp>
+#include <bowl/niche.hpp>
+
+#include <atomic>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 
 #include <cerrno>
+#include <cstdint>
+#include <cstdio>
 #include <cstring>
 
 namespace bowl
 {
 
 /**
- * Type-safe enum for all Linux errno #defines
+ *
+ * Errno values are always positive, so negative values are free to be used as niches. 0 is not
+ * one of them: an Errno is a plain enum, and Errno(0) can be created from an errno that was
+ * never set. It has to stay an error, not turn into the ok state of a MaybeError<Errno>.
  */
-enum class Errno : int
+template <>
+struct niche_traits<Errno>
 {
-    NOMEM = ENOMEM,
-    PERM = EPERM,
-    NOENT = ENOENT,
-    SRCH = ESRCH,
-    INTR = EINTR,
-    IO = EIO,
-    NXIO = ENXIO,
-    TOOBIG = E2BIG,
-    NOEXEC = ENOEXEC,
-    BADF = EBADF,
-    CHILD = ECHILD,
-    AGAIN = EAGAIN,
-    ACCES = EACCES,
-    FAULT = EFAULT,
-    NOTBLK = ENOTBLK,
-    BUSY = EBUSY,
-    EXIST = EEXIST,
-    XDEV = EXDEV,
-    NODEV = ENODEV,
-    NOTDIR = ENOTDIR,
-    ISDIR = EISDIR,
-    INVAL = EINVAL,
-    NFILE = ENFILE,
-    MFILE = EMFILE,
-    NOTTY = ENOTTY,
-    TXTBSY = ETXTBSY,
-    FBIG = EFBIG,
-    NOSPC = ENOSPC,
-    SPIPE = ESPIPE,
-    ROFS = EROFS,
-    MLINK = EMLINK,
-    PIPE = EPIPE,
-    DOM = EDOM,
-    RANGE = ERANGE,
-    DEADLK = EDEADLK,
-    NAMETOOLONG = ENAMETOOLONG,
-    NOLCK = ENOLCK,
-    NOSYS = ENOSYS,
-    NOTEMPTY = ENOTEMPTY,
-    LOOP = ELOOP,
-    WOULDBLOCK = EWOULDBLOCK,
-    NOMSG = ENOMSG,
-    IDRM = EIDRM,
-    CHRNG = ECHRNG,
-    L2NSYNC = EL2NSYNC,
-    L3HLT = EL3HLT,
-    L3RST = EL3RST,
-    LNRNG = ELNRNG,
-    UNATCH = EUNATCH,
-    NOCSI = ENOCSI,
-    L2HLT = EL2HLT,
-    BADE = EBADE,
-    BADR = EBADR,
-    XFULL = EXFULL,
-    NOANO = ENOANO,
-    BADRQC = EBADRQC,
-    BADSLT = EBADSLT,
-    DEADLOCK = EDEADLOCK,
-    BFONT = EBFONT,
-    NOSTR = ENOSTR,
-    NODATA = ENODATA,
-    TIME = ETIME,
-    NOSR = ENOSR,
-    NONET = ENONET,
-    NOPKG = ENOPKG,
-    REMOTE = EREMOTE,
-    NOLINK = ENOLINK,
-    ADV = EADV,
-    SRMNT = ESRMNT,
-    COMM = ECOMM,
-    PROTO = EPROTO,
-    MULTIHOP = EMULTIHOP,
-    DOTDOT = EDOTDOT,
-    BADMSG = EBADMSG,
-    OVERFLOW = EOVERFLOW,
-    NOTUNIQ = ENOTUNIQ,
-    BADFD = EBADFD,
-    REMCHG = EREMCHG,
-    LIBACC = ELIBACC,
-    LIBBAD = ELIBBAD,
-    LIBSCN = ELIBSCN,
-    LIBMAX = ELIBMAX,
-    LIBEXEC = ELIBEXEC,
-    ILSEQ = EILSEQ,
-    RESTART = ERESTART,
-    STRPIPE = ESTRPIPE,
-    USERS = EUSERS,
-    NOTSOCK = ENOTSOCK,
-    DESTADDRREQ = EDESTADDRREQ,
-    MSGSIZE = EMSGSIZE,
-    PROTOTYPE = EPROTOTYPE,
-    NOPROTOOPT = ENOPROTOOPT,
-    PROTONOSUPPORT = EPROTONOSUPPORT,
-    SOCKTNOSUPPORT = ESOCKTNOSUPPORT,
-    OPNOTSUPP = EOPNOTSUPP,
-    PFNOSUPPORT = EPFNOSUPPORT,
-    AFNOSUPPORT = EAFNOSUPPORT,
-    ADDRINUSE = EADDRINUSE,
-    ADDRNOTAVAIL = EADDRNOTAVAIL,
-    NETDOWN = ENETDOWN,
-    NETUNREACH = ENETUNREACH,
-    NETRESET = ENETRESET,
-    CONNABORTED = ECONNABORTED,
-    CONNRESET = ECONNRESET,
-    NOBUFS = ENOBUFS,
-    ISCONN = EISCONN,
-    NOTCONN = ENOTCONN,
-    SHUTDOWN = ESHUTDOWN,
-    TOOMANYREFS = ETOOMANYREFS,
-    TIMEDOUT = ETIMEDOUT,
-    CONNREFUSED = ECONNREFUSED,
-    HOSTDOWN = EHOSTDOWN,
-    HOSTUNREACH = EHOSTUNREACH,
-    ALREADY = EALREADY,
-    INPROGRESS = EINPROGRESS,
-    STALE = ESTALE,
-    UCLEAN = EUCLEAN,
-    NOTNAM = ENOTNAM,
-    NAVAIL = ENAVAIL,
-    ISNAM = EISNAM,
-    REMOTEIO = EREMOTEIO,
-    DQUOT = EDQUOT,
-    NOMEDIUM = ENOMEDIUM,
-    MEDIUMTYPE = EMEDIUMTYPE,
-    CANCELED = ECANCELED,
-    NOKEY = ENOKEY,
-    KEYEXPIRED = EKEYEXPIRED,
-    KEYREVOKED = EKEYREVOKED,
-    KEYREJECTED = EKEYREJECTED,
-    OWNERDEAD = EOWNERDEAD,
-    NOTRECOVERABLE = ENOTRECOVERABLE,
-    RFKILL = ERFKILL,
-    HWPOISON = EHWPOISON,
+    static constexpr std::size_t count = 4096;
+    static constexpr std::size_t offset = 0;
+
+    static void store(void* x, std::size_t n)
+    {
+        int val = -1 - static_cast<int>(n);
+        std::memcpy(x, &val, sizeof(val));
+    }
+
+    static std::size_t load(const void* x)
+    {
+        int val;
+        std::memcpy(&val, x, sizeof(val));
+
+        if (val < 0 && val >= -static_cast<int>(count))
+        {
+            return static_cast<std::size_t>(-1 - val);
+        }
+        return count;
+    }
 };
 
 /**
  *
- * Base class for all Error types `E` in Expected<T, E>, MaybeError<E>,...
+ * Optional base class for type-erased errors.
+ *
+ * Error types `E` in Expected<T, E>, MaybeError<E>,... do not have to derive from this,
+ * they only have to be usable through error_traits<E>. Deriving from Error adds a vtable
+ * pointer to every E, so only do it if you need to handle errors through an `Error&`.
+ *
+ * ErrorAdapter<E> wraps any error type into an Error.
  */
 class Error
 {
 public:
+    virtual ~Error() = default;
+
     /**
      * Give a human-readable representation of the error.
      */
@@ -167,6 +77,38 @@ public:
      */
     virtual void throw_as_exception() const = 0;
 };
+
+/**
+ *
+ * Adapter that makes any error type E usable through the virtual Error interface.
+ */
+template <class E>
+class ErrorAdapter final : public Error
+{
+public:
+    ErrorAdapter(E&& err) : err_(std::move(err))
+    {
+    }
+
+    std::string display() const override
+    {
+        return std::string(error_traits<E>::display(err_));
+    }
+
+    void throw_as_exception() const override
+    {
+        error_traits<E>::throw_as_exception(err_);
+    }
+
+    const E& get() const
+    {
+        return err_;
+    }
+
+private:
+    E err_;
+};
+
 class ErrnoError;
 
 /**
@@ -178,9 +120,13 @@ class ErrnoException : std::exception
 public:
     ErrnoException(ErrnoError err);
 
+    ErrnoException(Errno err) : errno_(err)
+    {
+    }
+
     const char* what() const noexcept override
     {
-        return strerror(static_cast<int>(errno_));
+        return errno_info(errno_).description.data();
     }
 
 protected:
@@ -189,35 +135,405 @@ protected:
 
 /**
  *
- * class Error wrapper around Unix `errno`s
+ * Errors wrapped around Unix `errno`s.
+ *
+ * ErrnoError is exactly as big as an int. Its description and name come from the constexpr
+ * table in errno.hpp, so displaying it never allocates.
  */
-class ErrnoError : public Error
+class ErrnoError
 {
 public:
-    ErrnoError() : errno_(static_cast<Errno>(errno))
+    /**
+     * The current errno. If it is not set, the error is EIO, see ErrnoError(Errno).
+     */
+    ErrnoError() : errno_(valid(static_cast<Errno>(errno)))
     {
     }
 
-    std::string display() const override
+    /**
+     * 0 and negative values are no errnos, they are turned into EIO. So every ErrnoError is an
+     * error, and 0 and negative values are free to be used as niches.
+     */
+    explicit ErrnoError(Errno err) : errno_(valid(err))
+    {
+    }
+
+    /**
+     * Creates an ErrnoError from the return value of a raw syscall, which is the negated errno
+     * on failure.
+     */
+    static ErrnoError from_raw(int ret)
+    {
+        return ErrnoError(static_cast<Errno>(-ret));
+    }
+
+    /**
+     * The description of the errno, as given by strerror() but without allocating and
+     * thread-safe. The view points to a NUL-terminated string literal.
+     */
+    std::string_view display() const
+    {
+        return errno_info(errno_).description;
+    }
+
+    /**
+     * The symbolic name of the errno, e.g. "ENOENT".
+     */
+    std::string_view name() const
+    {
+        return errno_info(errno_).name;
+    }
+
+    /**
+     * Writes the description into `buf`, see errno_display_to().
+     */
+    std::size_t display_to(char* buf, std::size_t size) const
     {
-        return strerror(static_cast<int>(errno_));
+        return errno_display_to(errno_, buf, size);
     }
 
-    enum Errno errnum()
+    enum Errno errnum() const
     {
         return errno_;
     }
 
-    [[noreturn]] void throw_as_exception() const override
+    [[noreturn]] void throw_as_exception() const
     {
-        throw ErrnoException(*this);
+        detail::throw_exception(ErrnoException(*this));
     }
 
 private:
+    static Errno valid(Errno err)
+    {
+        return BOWL_LIKELY(static_cast<int>(err) > 0) ? err : Errno::IO;
+    }
+
     enum Errno errno_;
 };
 
-class CustomError;
+/**
+ *
+ * An ErrnoError is always positive, so unlike Errno it can use 0 as a niche, with ok stored as
+ * 0. This makes MaybeError<ErrnoError> a single int which is 0 on success, just like the return
+ * value of most syscalls.
+ */
+template <>
+struct niche_traits<ErrnoError>
+{
+    static constexpr std::size_t count = 4096;
+    static constexpr std::size_t offset = 0;
+
+    static void store(void* x, std::size_t n)
+    {
+        int val = -static_cast<int>(n);
+        std::memcpy(x, &val, sizeof(val));
+    }
+
+    static std::size_t load(const void* x)
+    {
+        int val;
+        std::memcpy(&val, x, sizeof(val));
+
+        if (val <= 0 && val > -static_cast<int>(count))
+        {
+            return static_cast<std::size_t>(-val);
+        }
+        return count;
+    }
+};
+
+/**
+ *
+ * Expected<std::size_t, ErrnoError> is packed into a single ssize_t, negative values being the
+ * negated errno.
+ */
+template <>
+struct errno_word_traits<ErrnoError>
+{
+    static int to_errno(const ErrnoError& err)
+    {
+        return static_cast<int>(err.errnum());
+    }
+
+    static ErrnoError from_errno(int errnum)
+    {
+        return ErrnoError(static_cast<Errno>(errnum));
+    }
+};
+
+/**
+ *
+ * Errno itself can also be used as an error type.
+ */
+template <>
+struct error_traits<Errno>
+{
+    static std::string_view display(Errno err)
+    {
+        return errno_info(err).description;
+    }
+
+    [[noreturn]] static void throw_as_exception(Errno err)
+    {
+        detail::throw_exception(ErrnoException(err));
+    }
+};
+
+namespace detail
+{
+
+/**
+ * An entry in the table of interned messages. Entries are never removed.
+ */
+struct InternNode
+{
+    std::string_view msg;
+    InternNode* next;
+};
+
+/**
+ * Returns a NUL-terminated copy of `msg` which lives until the end of the program. Equal messages
+ * share one copy, so only the first call with a message allocates.
+ *
+ * The table is a fixed array of lock-free lists, which are only ever prepended to. A thread that
+ * loses the race to prepend only compares against the entries added in the meantime.
+ */
+inline const char* intern(std::string_view msg)
+{
+    static std::atomic<InternNode*> buckets[256];
+
+    std::atomic<InternNode*>& bucket = buckets[std::hash<std::string_view>{}(msg) % 256];
+    InternNode* head = bucket.load(std::memory_order_acquire);
+    InternNode* checked = nullptr;
+    InternNode* node = nullptr;
+
+    while (true)
+    {
+        for (InternNode* it = head; it != checked; it = it->next)
+        {
+            if (it->msg == msg)
+            {
+                if (node != nullptr)
+                {
+                    delete[] node->msg.data();
+                    delete node;
+                }
+                return it->msg.data();
+            }
+        }
+
+        if (node == nullptr)
+        {
+            char* copy = new char[msg.size() + 1];
+            std::memcpy(copy, msg.data(), msg.size());
+            copy[msg.size()] = '\0';
+
+            node = new InternNode{ std::string_view(copy, msg.size()), nullptr };
+        }
+
+        node->next = head;
+        checked = head;
+
+        if (bucket.compare_exchange_weak(head, node, std::memory_order_release,
+                                         std::memory_order_acquire))
+        {
+            return node->msg.data();
+        }
+    }
+}
+
+} // namespace detail
+
+/**
+ *
+ * Error type for just giving an error with a custom message
+ *
+ * Creating, copying and moving a CustomError does not allocate, unless it holds a long message
+ * that is neither a literal nor interned:
+ *
+ * - `CustomError::literal("queue full")` refers to a string with static storage duration
+ * - messages of up to `inline_capacity` characters are kept inline
+ * - `CustomError::interned(msg)` shares one copy of the message with all other errors interned
+ *   with the same message, which is kept until the end of the program. Use it for messages from
+ *   a bounded set, which are created too often to be copied every time.
+ * - longer messages are copied onto the heap
+ */
+class CustomError
+{
+public:
+    static constexpr std::size_t inline_capacity = 22;
+
+    enum class Storage : std::uint8_t
+    {
+        literal,
+        small,
+        interned,
+        heap,
+    };
+
+    /**
+     * Copies `msg`, inline if it is short enough and onto the heap otherwise.
+     */
+    CustomError(std::string_view msg)
+    {
+        copy_message(msg);
+    }
+
+    /**
+     * Copies a std::string, a string literal or anything else that converts to a
+     * std::string_view, so they convert to a CustomError in a single step.
+     */
+    template <class S, std::enable_if_t<std::is_convertible_v<const S&, std::string_view>, int> = 0>
+    CustomError(const S& msg) : CustomError(std::string_view(msg))
+    {
+    }
+
+    /**
+     * Refers to the NUL-terminated `msg` without copying it, `msg` has to outlive the error.
+     */
+    static CustomError literal(const char* msg) noexcept
+    {
+        return CustomError(Storage::literal, msg, std::strlen(msg));
+    }
+
+    /**
+     * Refers to the interned copy of `msg`, see detail::intern().
+     */
+    static CustomError interned(std::string_view msg)
+    {
+        return CustomError(Storage::interned, detail::intern(msg), msg.size());
+    }
+
+    CustomError(const CustomError& other)
+    {
+        if (other.storage_ == Storage::heap)
+        {
+            copy_message(other.display());
+        }
+        else
+        {
+            copy_from(other);
+        }
+    }
+
+    /**
+     * Moves the message of `other`, which is left empty.
+     */
+    CustomError(CustomError&& other) noexcept
+    {
+        copy_from(other);
+        other.reset();
+    }
+
+    CustomError& operator=(const CustomError& other)
+    {
+        if (this != &other)
+        {
+            *this = CustomError(other);
+        }
+        return *this;
+    }
+
+    CustomError& operator=(CustomError&& other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            copy_from(other);
+            other.reset();
+        }
+        return *this;
+    }
+
+    ~CustomError()
+    {
+        release();
+    }
+
+    std::string_view display() const
+    {
+        return std::string_view(c_str(), size_);
+    }
+
+    /**
+     * The message, NUL-terminated.
+     */
+    const char* c_str() const
+    {
+        return storage_ == Storage::small ? small_ : ptr_;
+    }
+
+    /**
+     * Where the message is kept.
+     */
+    Storage storage() const
+    {
+        return storage_;
+    }
+
+    [[noreturn]] void throw_as_exception() const;
+
+private:
+    CustomError(Storage storage, const char* ptr, std::size_t size)
+    : ptr_(ptr), size_(static_cast<std::uint32_t>(size)), storage_(storage)
+    {
+    }
+
+    void release()
+    {
+        if (storage_ == Storage::heap)
+        {
+            delete[] ptr_;
+        }
+    }
+
+    void copy_message(std::string_view msg)
+    {
+        char* dst;
+
+        if (msg.size() <= inline_capacity)
+        {
+            storage_ = Storage::small;
+            dst = small_;
+        }
+        else
+        {
+            storage_ = Storage::heap;
+            dst = new char[msg.size() + 1];
+            ptr_ = dst;
+        }
+
+        std::memcpy(dst, msg.data(), msg.size());
+        dst[msg.size()] = '\0';
+        size_ = static_cast<std::uint32_t>(msg.size());
+    }
+
+    /**
+     * Copies the representation of `other`, a heap message is then owned by both.
+     */
+    void copy_from(const CustomError& other)
+    {
+        std::memcpy(small_, other.small_, sizeof(small_));
+        size_ = other.size_;
+        storage_ = other.storage_;
+    }
+
+    void reset()
+    {
+        ptr_ = "";
+        size_ = 0;
+        storage_ = Storage::literal;
+    }
+
+    union
+    {
+        const char* ptr_;
+        char small_[inline_capacity + 1];
+    };
+
+    std::uint32_t size_;
+    Storage storage_;
+};
 
 /**
  *
@@ -226,51 +542,377 @@ class CustomError;
 class CustomException : public std::exception
 {
 public:
-    CustomException(CustomError err);
+    CustomException(CustomError err) : err_(std::move(err))
+    {
+    }
 
     const char* what() const noexcept override
     {
         return err_.c_str();
     }
 
+    const CustomError& error() const
+    {
+        return err_;
+    }
+
 protected:
-    std::string err_;
+    CustomError err_;
 };
 
+inline void CustomError::throw_as_exception() const
+{
+    detail::throw_exception(CustomException(*this));
+}
+
+namespace detail
+{
+
 /**
+ * How an argument of a FormattedError is kept and rendered.
+ */
+enum class FormatType : std::uint8_t
+{
+    none,
+    boolean,
+    character,
+    signed_int,
+    unsigned_int,
+    floating,
+    string,
+    pointer,
+    errnum,
+};
+
+union FormatValue
+{
+    long long i;
+    unsigned long long u;
+    double d;
+    const char* s;
+    const void* p;
+};
+
+template <class X>
+constexpr bool always_false_v = false;
+
+/**
+ * Captures `x` into a FormatValue, returning how it is rendered.
+ */
+template <class X>
+FormatType capture_format_arg(const X& x, FormatValue& value)
+{
+    if constexpr (std::is_same_v<X, bool>)
+    {
+        value.u = x;
+        return FormatType::boolean;
+    }
+    else if constexpr (std::is_same_v<X, char>)
+    {
+        value.i = x;
+        return FormatType::character;
+    }
+    else if constexpr (std::is_same_v<X, Errno>)
+    {
+        value.i = static_cast<int>(x);
+        return FormatType::errnum;
+    }
+    else if constexpr (std::is_same_v<X, ErrnoError>)
+    {
+        value.i = static_cast<int>(x.errnum());
+        return FormatType::errnum;
+    }
+    else if constexpr (std::is_enum_v<X>)
+    {
+        return capture_format_arg(static_cast<std::underlying_type_t<X>>(x), value);
+    }
+    else if constexpr (std::is_integral_v<X> && std::is_signed_v<X>)
+    {
+        value.i = x;
+        return FormatType::signed_int;
+    }
+    else if constexpr (std::is_integral_v<X>)
+    {
+        value.u = x;
+        return FormatType::unsigned_int;
+    }
+    else if constexpr (std::is_floating_point_v<X>)
+    {
+        value.d = static_cast<double>(x);
+        return FormatType::floating;
+    }
+    else if constexpr (std::is_convertible_v<const X&, const char*>)
+    {
+        value.s = x;
+        return FormatType::string;
+    }
+    else if constexpr (std::is_pointer_v<X>)
+    {
+        value.p = x;
+        return FormatType::pointer;
+    }
+    else
+    {
+        static_assert(always_false_v<X>, "FormattedError can not capture this argument type");
+        return FormatType::none;
+    }
+}
+
+/**
+ * Appends to a buffer of `size` bytes with the truncation rules of snprintf(), counting the
+ * length of the complete output.
+ */
+class FormatWriter
+{
+public:
+    FormatWriter(char* buf, std::size_t size)
+    : buf_(buf), cap_(size > 0 ? size - 1 : 0), size_(size)
+    {
+    }
+
+    void put(const char* str, std::size_t n)
+    {
+        if (len_ < cap_)
+        {
+            std::memcpy(buf_ + len_, str, n < cap_ - len_ ? n : cap_ - len_);
+        }
+        len_ += n;
+    }
+
+    void put(std::string_view str)
+    {
+        put(str.data(), str.size());
+    }
+
+    void put_unsigned(unsigned long long u, bool negative = false)
+    {
+        char tmp[24];
+        char* p = tmp + sizeof(tmp);
+
+        do
+        {
+            *--p = static_cast<char>('0' + u % 10);
+            u /= 10;
+        } while (u != 0);
+
+        if (negative)
+        {
+            *--p = '-';
+        }
+        put(p, static_cast<std::size_t>(tmp + sizeof(tmp) - p));
+    }
+
+    void put_signed(long long i)
+    {
+        unsigned long long u = static_cast<unsigned long long>(i);
+        put_unsigned(i < 0 ? 0 - u : u, i < 0);
+    }
+
+    template <class X>
+    void put_printf(const char* fmt, X x)
+    {
+        char tmp[32];
+        int n = std::snprintf(tmp, sizeof(tmp), fmt, x);
+        put(tmp, n > 0 ? static_cast<std::size_t>(n) : 0);
+    }
+
+    std::size_t finish()
+    {
+        if (size_ > 0)
+        {
+            buf_[len_ < cap_ ? len_ : cap_] = '\0';
+        }
+        return len_;
+    }
+
+private:
+    char* buf_;
+    std::size_t cap_;
+    std::size_t size_;
+    std::size_t len_ = 0;
+};
+
+} // namespace detail
+
+/**
+ *
+ * Error type whose message is formatted only when it is displayed.
+ *
+ * Creating a FormattedError only stores the format string and up to `max_args` arguments, so
+ * errors that are propagated and then dropped or retried never pay for formatting:
+ *
+ *     return bowl::Unexpected(bowl::FormattedError("short read: {} of {} bytes", got, want));
+ *
+ * Every `{}` in the format string is replaced by the next argument, `{{` and `}}` stand for
+ * literal braces. Placeholders without an argument are kept as they are.
+ *
+ * Arguments can be bools, chars, integers, enums, floating point numbers, pointers, Errno and
+ * ErrnoError, which are rendered as their description. Strings are kept as `const char*` without
+ * copying them, so they have to outlive the error, just like the format string.
  *
- * class Error specialization for just giving an error with a custom message
+ * A FormattedError is trivially copyable and never allocates, only display() does.
  */
-class CustomError : public Error
+class FormattedError
 {
 public:
-    CustomError(std::string str) : str_(str)
+    static constexpr std::size_t max_args = 4;
+
+    template <class... Args>
+    FormattedError(const char* fmt, const Args&... args) : fmt_(fmt), types_{}
     {
+        static_assert(sizeof...(Args) <= max_args,
+                      "FormattedError takes at most max_args arguments");
+        static_assert((std::is_trivially_copyable_v<Args> && ...),
+                      "arguments of FormattedError have to be trivially copyable");
+
+        [[maybe_unused]] std::size_t i = 0;
+        ((types_[i] = detail::capture_format_arg(args, values_[i]), i++), ...);
     }
 
-    std::string display() const override
+    /**
+     * Formats the message into a std::string. Messages that fit into a buffer on the stack are
+     * formatted only once.
+     */
+    std::string display() const
     {
-        return str_;
+        char buf[256];
+        std::size_t size = display_to(buf, sizeof(buf));
+
+        if (size < sizeof(buf))
+        {
+            return std::string(buf, size);
+        }
+
+        std::string msg(size, '\0');
+        display_to(msg.data(), size + 1);
+        return msg;
     }
 
-    [[noreturn]] void throw_as_exception() const override
+    /**
+     * Formats the message into `buf`, truncating it to `size - 1` characters and always
+     * NUL-terminating it if `size > 0`, just like snprintf().
+     *
+     * Returns the length of the complete message, without the NUL.
+     */
+    BOWL_COLD std::size_t display_to(char* buf, std::size_t size) const
     {
-        throw CustomException(*this);
+        detail::FormatWriter out(buf, size);
+        std::size_t arg = 0;
+        const char* lit = fmt_;
+        const char* p = fmt_;
+
+        for (; *p != '\0'; p++)
+        {
+            if ((p[0] == '{' && p[1] == '{') || (p[0] == '}' && p[1] == '}'))
+            {
+                out.put(lit, static_cast<std::size_t>(p - lit) + 1);
+                lit = ++p + 1;
+            }
+            else if (p[0] == '{' && p[1] == '}' && arg < max_args &&
+                     types_[arg] != detail::FormatType::none)
+            {
+                out.put(lit, static_cast<std::size_t>(p - lit));
+                put_arg(out, arg++);
+                lit = ++p + 1;
+            }
+        }
+
+        out.put(lit, static_cast<std::size_t>(p - lit));
+        return out.finish();
+    }
+
+    /**
+     * The format string the error was created with.
+     */
+    const char* format() const
+    {
+        return fmt_;
     }
 
+    [[noreturn]] void throw_as_exception() const;
+
 private:
-    CustomError()
+    void put_arg(detail::FormatWriter& out, std::size_t arg) const
     {
+        const detail::FormatValue& value = values_[arg];
+
+        switch (types_[arg])
+        {
+        case detail::FormatType::boolean:
+            out.put(value.u ? "true" : "false");
+            break;
+        case detail::FormatType::character:
+        {
+            char c = static_cast<char>(value.i);
+            out.put(&c, 1);
+            break;
+        }
+        case detail::FormatType::signed_int:
+            out.put_signed(value.i);
+            break;
+        case detail::FormatType::unsigned_int:
+            out.put_unsigned(value.u);
+            break;
+        case detail::FormatType::floating:
+            out.put_printf("%g", value.d);
+            break;
+        case detail::FormatType::string:
+            out.put(value.s != nullptr ? value.s : "(null)");
+            break;
+        case detail::FormatType::pointer:
+            out.put_printf("%p", value.p);
+            break;
+        case detail::FormatType::errnum:
+            out.put(errno_info(static_cast<Errno>(value.i)).description);
+            break;
+        case detail::FormatType::none:
+            break;
+        }
     }
 
-    std::string str_;
+    const char* fmt_;
+    detail::FormatValue values_[max_args];
+    detail::FormatType types_[max_args];
 };
 
-inline ErrnoException::ErrnoException(ErrnoError err) : errno_(err.errnum())
+/**
+ *
+ * The format string of a FormattedError is never a pointer into the first page of memory, so
+ * MaybeError<FormattedError> needs no extra state byte.
+ */
+template <>
+struct niche_traits<FormattedError> : niche_traits<const char*>
+{
+};
+
+/**
+ *
+ * Corresponding exception type to FormattedError. The message is formatted when the exception is
+ * thrown, and it can also be caught as a CustomException.
+ */
+class FormattedException : public CustomException
+{
+public:
+    FormattedException(const FormattedError& err)
+    : CustomException(CustomError(err.display())), formatted_(err)
+    {
+    }
+
+    const FormattedError& formatted_error() const
+    {
+        return formatted_;
+    }
+
+protected:
+    FormattedError formatted_;
+};
+
+inline void FormattedError::throw_as_exception() const
 {
+    detail::throw_exception(FormattedException(*this));
 }
 
-inline CustomException::CustomException(CustomError err) : err_(err.display())
+inline ErrnoException::ErrnoException(ErrnoError err) : errno_(err.errnum())
 {
 }
 
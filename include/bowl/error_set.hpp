@@ -0,0 +1,401 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <bowl/error_traits.hpp>
+#include <bowl/exception.hpp>
+#include <bowl/niche.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace bowl
+{
+
+template <class... Es>
+class ErrorSet;
+
+namespace detail
+{
+
+template <std::size_t I, class E, class... Es>
+struct nth_type : nth_type<I - 1, Es...>
+{
+};
+
+template <class E, class... Es>
+struct nth_type<0, E, Es...>
+{
+    using type = E;
+};
+
+/**
+ * The index of E in Es, or sizeof...(Es) if it is not one of them.
+ */
+template <class E, class... Es>
+constexpr std::size_t type_index()
+{
+    constexpr bool same[] = { std::is_same_v<E, Es>... };
+
+    for (std::size_t i = 0; i < sizeof...(Es); i++)
+    {
+        if (same[i])
+        {
+            return i;
+        }
+    }
+    return sizeof...(Es);
+}
+
+template <class E, class... Es>
+constexpr bool is_one_of_v = (std::is_same_v<E, Es> || ...);
+
+template <class E, class... Es>
+constexpr std::size_t count_v = (std::size_t(std::is_same_v<E, Es>) + ...);
+
+template <class... Es>
+constexpr bool all_trivial_v =
+    ((std::is_trivially_copyable_v<Es> && std::is_trivially_destructible_v<Es>)&&...);
+
+constexpr std::size_t max_size(std::initializer_list<std::size_t> sizes)
+{
+    std::size_t max = 0;
+
+    for (std::size_t size : sizes)
+    {
+        max = size > max ? size : max;
+    }
+    return max;
+}
+
+template <class Set, class... Es>
+struct is_subset : std::false_type
+{
+};
+
+template <class... Fs, class... Es>
+struct is_subset<ErrorSet<Fs...>, Es...> : std::bool_constant<(is_one_of_v<Fs, Es...> && ...)>
+{
+};
+
+template <class E>
+using display_t = std::decay_t<decltype(error_traits<E>::display(std::declval<const E&>()))>;
+
+/**
+ * The storage of an ErrorSet: a buffer as big as the largest member followed by the index of the
+ * member it holds.
+ */
+template <class... Es>
+class ErrorSetData
+{
+public:
+    static constexpr std::size_t data_size = max_size({ sizeof(Es)... });
+
+protected:
+    static constexpr std::uint8_t valueless = sizeof...(Es);
+
+    /**
+     * Constructs the member D directly in the buffer from `args`.
+     */
+    template <class D, class... Args>
+    void emplace(Args&&... args)
+    {
+        ::new (static_cast<void*>(buf_)) D(std::forward<Args>(args)...);
+        index_ = static_cast<std::uint8_t>(type_index<D, Es...>());
+    }
+
+    template <class X>
+    void construct(X&& x)
+    {
+        emplace<std::decay_t<X>>(std::forward<X>(x));
+    }
+
+    /**
+     * Calls `f` with the member held by `self`, which must not be valueless. The chain of
+     * comparisons with the index is turned into a jump table by the compiler.
+     */
+    template <std::size_t I = 0, class Self, class F>
+    static decltype(auto) dispatch(Self& self, F&& f)
+    {
+        using E = typename nth_type<I, Es...>::type;
+        using Q = std::conditional_t<std::is_const_v<Self>, const E, E>;
+
+        if constexpr (I + 1 == sizeof...(Es))
+        {
+            return f(*std::launder(reinterpret_cast<Q*>(self.buf_)));
+        }
+        else
+        {
+            if (self.index_ == I)
+            {
+                return f(*std::launder(reinterpret_cast<Q*>(self.buf_)));
+            }
+            return dispatch<I + 1>(self, std::forward<F>(f));
+        }
+    }
+
+    alignas(Es...) unsigned char buf_[data_size];
+    std::uint8_t index_;
+};
+
+/**
+ * Special members of an ErrorSet with trivially copyable and destructible members: all defaulted.
+ */
+template <bool Trivial, class... Es>
+class ErrorSetBase : public ErrorSetData<Es...>
+{
+};
+
+/**
+ * Special members of an ErrorSet with other members, dispatching to the held member.
+ */
+template <class... Es>
+class ErrorSetBase<false, Es...> : public ErrorSetData<Es...>
+{
+    using Data = ErrorSetData<Es...>;
+
+protected:
+    ErrorSetBase()
+    {
+        this->index_ = Data::valueless;
+    }
+
+    ErrorSetBase(const ErrorSetBase& other) : ErrorSetBase()
+    {
+        copy_from(other);
+    }
+
+    ErrorSetBase(ErrorSetBase&& other) noexcept((std::is_nothrow_move_constructible_v<Es> && ...))
+    : ErrorSetBase()
+    {
+        move_from(other);
+    }
+
+    /**
+     * Destroys the held member and copy constructs the one of `other`. If that throws, this
+     * ErrorSet is left valueless and may only be destroyed or assigned to.
+     */
+    ErrorSetBase& operator=(const ErrorSetBase& other)
+    {
+        if (this != &other)
+        {
+            destroy();
+            copy_from(other);
+        }
+        return *this;
+    }
+
+    ErrorSetBase& operator=(ErrorSetBase&& other) noexcept(
+        (std::is_nothrow_move_constructible_v<Es> && ...))
+    {
+        if (this != &other)
+        {
+            destroy();
+            move_from(other);
+        }
+        return *this;
+    }
+
+    ~ErrorSetBase()
+    {
+        destroy();
+    }
+
+private:
+    void copy_from(const ErrorSetBase& other)
+    {
+        if (other.index_ != Data::valueless)
+        {
+            Data::dispatch(other, [this](const auto& e) { this->construct(e); });
+        }
+    }
+
+    void move_from(ErrorSetBase& other)
+    {
+        if (other.index_ != Data::valueless)
+        {
+            Data::dispatch(other, [this](auto& e) { this->construct(std::move(e)); });
+        }
+    }
+
+    void destroy()
+    {
+        if (this->index_ != Data::valueless)
+        {
+            Data::dispatch(*this, [](auto& e) {
+                using D = std::decay_t<decltype(e)>;
+                e.~D();
+            });
+            this->index_ = Data::valueless;
+        }
+    }
+};
+
+} // namespace detail
+
+/**
+ *
+ * Error type that holds exactly one error out of the closed set of error types Es, without
+ * type erasure: `Expected<T, ErrorSet<ErrnoError, CatalogError>>`.
+ *
+ * The members are kept in a buffer as big as the largest of them, followed by a one byte index.
+ * display(), throw_as_exception() and visit() dispatch on the index with a chain of comparisons,
+ * which the compiler turns into a jump table, so there is no vtable and no allocation. An
+ * ErrorSet of trivially copyable members is trivially copyable, and the unused index values are
+ * niches, so MaybeError<ErrorSet<...>> needs no extra state byte.
+ *
+ * An ErrorSet converts implicitly from each of its members and from every ErrorSet whose members
+ * are a subset of its own. CHECK_ASSIGN and BOWL_TRY therefore widen the error of a callee
+ * automatically, and fail to compile if it is not part of the caller's set.
+ */
+template <class... Es>
+class ErrorSet : public detail::ErrorSetBase<detail::all_trivial_v<Es...>, Es...>
+{
+    static_assert(sizeof...(Es) > 0 && sizeof...(Es) < 255, "ErrorSet needs 1 to 254 members");
+    static_assert(((detail::count_v<Es, Es...> == 1) && ...),
+                  "the members of an ErrorSet have to be distinct");
+    static_assert((is_error_v<Es> && ...), "all members of an ErrorSet have to be error types");
+
+    using Data = detail::ErrorSetData<Es...>;
+
+public:
+    /**
+     * The type returned by display(): the display type of the members if they all agree on one,
+     * std::string otherwise.
+     */
+    using display_type = std::conditional_t<
+        (std::is_same_v<detail::display_t<Es>,
+                        detail::display_t<typename detail::nth_type<0, Es...>::type>> &&
+         ...),
+        detail::display_t<typename detail::nth_type<0, Es...>::type>, std::string>;
+
+    template <class E, class D = std::decay_t<E>,
+              std::enable_if_t<detail::is_one_of_v<D, Es...>, int> = 0>
+    ErrorSet(E&& err)
+    {
+        this->construct(std::forward<E>(err));
+    }
+
+    /**
+     * Constructs the member E in place from `args`, without moving it, so E does not need to be
+     * movable for this.
+     */
+    template <class E, class... Args, std::enable_if_t<detail::is_one_of_v<E, Es...>, int> = 0>
+    ErrorSet(std::in_place_type_t<E>, Args&&... args)
+    {
+        this->template emplace<E>(std::forward<Args>(args)...);
+    }
+
+    /**
+     * Widens an ErrorSet whose members are all members of this one.
+     */
+    template <class... Fs, std::enable_if_t<detail::is_subset<ErrorSet<Fs...>, Es...>::value &&
+                                                !std::is_same_v<ErrorSet<Fs...>, ErrorSet>,
+                                            int> = 0>
+    ErrorSet(const ErrorSet<Fs...>& other)
+    {
+        other.visit([this](const auto& e) { this->construct(e); });
+    }
+
+    template <class... Fs, std::enable_if_t<detail::is_subset<ErrorSet<Fs...>, Es...>::value &&
+                                                !std::is_same_v<ErrorSet<Fs...>, ErrorSet>,
+                                            int> = 0>
+    ErrorSet(ErrorSet<Fs...>&& other)
+    {
+        other.visit([this](auto& e) { this->construct(std::move(e)); });
+    }
+
+    /**
+     * The position of the held member in Es.
+     */
+    std::size_t index() const
+    {
+        return this->index_;
+    }
+
+    template <class E>
+    bool is() const
+    {
+        static_assert(detail::is_one_of_v<E, Es...>, "E is not a member of this ErrorSet");
+
+        return this->index_ == detail::type_index<E, Es...>();
+    }
+
+    /**
+     * The held member if it is an E, nullptr otherwise.
+     */
+    template <class E>
+    const E* as() const
+    {
+        return is<E>() ? std::launder(reinterpret_cast<const E*>(this->buf_)) : nullptr;
+    }
+
+    template <class E>
+    E* as()
+    {
+        return is<E>() ? std::launder(reinterpret_cast<E*>(this->buf_)) : nullptr;
+    }
+
+    /**
+     * Calls `f` with the held member. `f` has to accept every member and return the same type
+     * for all of them, so a visitor which forgets a member does not compile.
+     */
+    template <class F>
+    decltype(auto) visit(F&& f) const
+    {
+        return Data::dispatch(*this, std::forward<F>(f));
+    }
+
+    template <class F>
+    decltype(auto) visit(F&& f)
+    {
+        return Data::dispatch(*this, std::forward<F>(f));
+    }
+
+    display_type display() const
+    {
+        return visit([](const auto& e) {
+            using E = std::decay_t<decltype(e)>;
+            return display_type(error_traits<E>::display(e));
+        });
+    }
+
+    [[noreturn]] void throw_as_exception() const
+    {
+        visit([](const auto& e) {
+            using E = std::decay_t<decltype(e)>;
+            error_traits<E>::throw_as_exception(e);
+        });
+        detail::abort_with("throw_as_exception() of the error in an ErrorSet returned");
+    }
+};
+
+/**
+ *
+ * Index values past the last member are the niches of an ErrorSet. They are only used for
+ * ErrorSets of trivially copyable members, see has_niche_v.
+ */
+template <class... Es>
+struct niche_traits<ErrorSet<Es...>>
+{
+    static constexpr std::size_t count = 256 - sizeof...(Es);
+    static constexpr std::size_t offset = detail::ErrorSetData<Es...>::data_size;
+
+    static void store(void* x, std::size_t n)
+    {
+        static_cast<unsigned char*>(x)[offset] = static_cast<unsigned char>(sizeof...(Es) + n);
+    }
+
+    static std::size_t load(const void* x)
+    {
+        std::size_t val = static_cast<const unsigned char*>(x)[offset];
+        return val >= sizeof...(Es) ? val - sizeof...(Es) : count;
+    }
+};
+
+} // namespace bowl
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+namespace bowl
+{
+
+/**
+ *
+ * error_traits<E>: the static interface through which Expected, MaybeError and
+ * UnpackOkIfErrorException access an error of type E, without virtual dispatch.
+ *
+ * By default, it forwards to the member functions of E:
+ *
+ * - `display() const`: returns a human-readable representation of the error, as anything
+ *   that can be appended to a std::string (std::string, std::string_view, const char*)
+ * - `throw_as_exception() const`: throws the error as a corresponding exception
+ *
+ * Specialize it for error types that can not have member functions, like enums.
+ */
+template <class E>
+struct error_traits
+{
+    template <class X = E>
+    static auto display(const X& err) -> decltype(err.display())
+    {
+        return err.display();
+    }
+
+    template <class X = E>
+    static auto throw_as_exception(const X& err) -> decltype(err.throw_as_exception())
+    {
+        err.throw_as_exception();
+    }
+};
+
+/**
+ *
+ * error_conversion<From, To>: how CHECK_ASSIGN and BOWL_TRY turn the error `From` of an
+ * expression into the error type `To` of the enclosing function.
+ *
+ * By default, To is constructed from From, if it can be. Specialize it to convert between
+ * unrelated error types, providing `static To convert(From&& err)`.
+ */
+template <class From, class To>
+struct error_conversion
+{
+    template <class X = From, std::enable_if_t<std::is_constructible_v<To, X&&>, int> = 0>
+    static To convert(X&& err)
+    {
+        return To(std::move(err));
+    }
+};
+
+namespace detail
+{
+
+template <class From, class To, class = void>
+struct is_error_convertible : std::false_type
+{
+};
+
+template <class From, class To>
+struct is_error_convertible<
+    From, To, std::void_t<decltype(error_conversion<From, To>::convert(std::declval<From&&>()))>>
+: std::true_type
+{
+};
+
+template <class E, class = void>
+struct is_error : std::false_type
+{
+};
+
+template <class E>
+struct is_error<E, std::void_t<decltype(error_traits<E>::display(std::declval<const E&>())),
+                               decltype(error_traits<E>::throw_as_exception(
+                                   std::declval<const E&>()))>> : std::true_type
+{
+};
+
+} // namespace detail
+
+/**
+ * True if E can be used as an error type, i.e. error_traits<E> is usable for E.
+ */
+template <class E>
+constexpr bool is_error_v = detail::is_error<E>::value;
+
+} // namespace bowl
@@ -2,11 +2,46 @@
 
 #pragma once
 
+#include <bowl/config.hpp>
+#include <bowl/error_traits.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <exception>
-#include <string>
+#include <string_view>
+#include <utility>
 
 namespace bowl
 {
+
+namespace detail
+{
+
+/**
+ * Prints `msg` to stderr and aborts.
+ */
+[[noreturn]] BOWL_COLD inline void abort_with(const char* msg)
+{
+    std::fprintf(stderr, "bowl: %s\n", msg);
+    std::abort();
+}
+
+/**
+ * Throws `ex`, or prints its message and aborts if BOWL_NO_EXCEPTIONS is defined.
+ */
+template <class Ex>
+[[noreturn]] BOWL_COLD void throw_exception(Ex&& ex)
+{
+#ifdef BOWL_NO_EXCEPTIONS
+    abort_with(ex.what());
+#else
+    throw std::forward<Ex>(ex);
+#endif
+}
+
+} // namespace detail
+
 /**
  * Exception thrown if you unpack_(ok/error) a MaybeError or Expected
  * that has already been unpacked.
@@ -45,17 +80,47 @@ class UnpackOkIfErrorException : public std::exception
 public:
     UnpackOkIfErrorException(const E& err)
     {
-        what_ =
-            "Trying to access unpack_ok() but object was in !ok() state, error: " + err.display();
+        // display() may return a std::string, a std::string_view or a C string
+        auto&& shown = error_traits<E>::display(err);
+        std::string_view msg(shown);
+
+        what_ = static_cast<char*>(std::malloc(prefix.size() + msg.size() + 1));
+        if (what_ != nullptr)
+        {
+            std::memcpy(what_, prefix.data(), prefix.size());
+            std::memcpy(what_ + prefix.size(), msg.data(), msg.size());
+            what_[prefix.size() + msg.size()] = '\0';
+        }
+    }
+
+    UnpackOkIfErrorException(const UnpackOkIfErrorException& other)
+    : what_(other.what_ != nullptr ? static_cast<char*>(std::malloc(std::strlen(other.what_) + 1))
+                                   : nullptr)
+    {
+        if (what_ != nullptr)
+        {
+            std::strcpy(what_, other.what_);
+        }
+    }
+
+    UnpackOkIfErrorException& operator=(const UnpackOkIfErrorException&) = delete;
+
+    ~UnpackOkIfErrorException() override
+    {
+        std::free(what_);
     }
 
     const char* what() const noexcept override
     {
-        return what_.c_str();
+        // Without the error, if there was no memory left for the message
+        return what_ != nullptr ? what_ : prefix.data();
     }
 
 private:
-    std::string what_;
+    static constexpr std::string_view prefix =
+        "Trying to access unpack_ok() but object was in !ok() state, error: ";
+
+    char* what_;
 };
 
 } // namespace bowl
@@ -2,192 +2,1375 @@
 
 #pragma once
 
+#include <bowl/error_traits.hpp>
 #include <bowl/exception.hpp>
+#include <bowl/fwd.hpp>
+#include <bowl/policy.hpp>
 #include <bowl/unexpected.hpp>
 
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>
+
 namespace bowl
 {
 
-/**
- *
- * Expected<T, E>: a container which can either contain a success object of type T or an
- * error object of type E.
- *
- * E _has_ to be derived from bowl::Error
- */
-template <class T, class E>
-class Expected
-{
-public:
+namespace detail
+{
+
+/**
+ * True if an Expected<T, E> can be copied and destroyed bytewise,
+ * which allows it to be passed around in registers.
+ */
+template <class T, class E>
+constexpr bool is_trivial_payload_v =
+    std::is_trivially_copyable_v<T> && std::is_trivially_copyable_v<E> &&
+    std::is_trivially_destructible_v<T> && std::is_trivially_destructible_v<E>;
+
+template <class T, class E, class Policy>
+constexpr Layout expected_layout_v =
+    is_errno_word_v<T, E> ? Layout::errno_word
+    : !is_trivial_payload_v<T, E> ? Layout::generic
+    : has_niche_v<T>(sizeof(E), niche_spares(Policy::checked)) ? Layout::niche_ok
+    : has_niche_v<E>(sizeof(T), niche_spares(Policy::checked)) ? Layout::niche_error
+                                                               : Layout::trivial;
+
+/**
+ * std::addressof() without <memory>.
+ */
+template <class T>
+constexpr T* address_of(T& ref) noexcept
+{
+    return __builtin_addressof(ref);
+}
+
+template <class M, class Obj, class... Args>
+constexpr decltype(auto) invoke_member(M member, Obj&& obj, Args&&... args);
+
+/**
+ * detail::invoke() without <functional>, which is one of the most expensive standard headers to
+ * parse. Calls `f` with `args`, or a pointer to member on an object or a plain pointer to one.
+ */
+template <class F, class... Args>
+constexpr decltype(auto) invoke(F&& f, Args&&... args)
+{
+    if constexpr (std::is_member_pointer_v<std::decay_t<F>>)
+    {
+        return invoke_member(f, std::forward<Args>(args)...);
+    }
+    else
+    {
+        return std::forward<F>(f)(std::forward<Args>(args)...);
+    }
+}
+
+template <class M, class Obj, class... Args>
+constexpr decltype(auto) invoke_member(M member, Obj&& obj, Args&&... args)
+{
+    if constexpr (std::is_pointer_v<std::decay_t<Obj>>)
+    {
+        return invoke_member(member, *obj, std::forward<Args>(args)...);
+    }
+    else if constexpr (std::is_member_function_pointer_v<M>)
+    {
+        return (std::forward<Obj>(obj).*member)(std::forward<Args>(args)...);
+    }
+    else
+    {
+        return (std::forward<Obj>(obj).*member);
+    }
+}
+
+/**
+ * The empty success object stored by Expected<void, E>.
+ */
+struct Unit
+{
+};
+
+/**
+ *
+ * How the success type T of an Expected<T, E> is kept in the storage: objects as they are,
+ * lvalue references as pointers and void as an empty Unit.
+ *
+ * - `type`: the type stored in the union
+ * - `param_type`: the parameter of the converting constructor of Expected
+ * - `constructible<Args...>()`: true if `make(args...)` can be called
+ * - `make(args...)`: creates the stored object for the in place constructor
+ * - `store(make)`: creates the stored object from the success object returned by `make()`
+ */
+template <class T>
+struct OkStorage
+{
+    using type = T;
+    using param_type = T&&;
+
+    template <class... Args>
+    static constexpr bool constructible()
+    {
+        return std::is_constructible_v<T, Args...>;
+    }
+
+    template <class... Args>
+    static T make(Args&&... args)
+    {
+        return T(std::forward<Args>(args)...);
+    }
+
+    template <class Make>
+    static T store(Make& make)
+    {
+        return make();
+    }
+};
+
+template <class T>
+struct OkStorage<T&>
+{
+    using type = T*;
+    using param_type = T&;
+
+    template <class... Args>
+    static constexpr bool constructible()
+    {
+        if constexpr (sizeof...(Args) == 1)
+        {
+            return (std::is_lvalue_reference_v<Args> && ...) &&
+                   (std::is_convertible_v<Args, T&> && ...);
+        }
+        return false;
+    }
+
+    static T* make(T& ref)
+    {
+        return address_of(ref);
+    }
+
+    template <class Make>
+    static T* store(Make& make)
+    {
+        T& ref = make();
+        return address_of(ref);
+    }
+};
+
+template <>
+struct OkStorage<void>
+{
+    using type = Unit;
+    using param_type = Unit;
+
+    template <class... Args>
+    static constexpr bool constructible()
+    {
+        return sizeof...(Args) == 0;
+    }
+
+    static Unit make(Unit = {})
+    {
+        return {};
+    }
+
+    template <class Make>
+    static Unit store(Make& make)
+    {
+        make();
+        return {};
+    }
+};
+
+/**
+ * Result of invoking `F` with the success object of type `A`, or without arguments if `A` is void.
+ */
+template <class F, class A>
+struct invoke_ok_result
+{
+    using type = std::invoke_result_t<F, A>;
+};
+
+template <class F>
+struct invoke_ok_result<F, void>
+{
+    using type = std::invoke_result_t<F>;
+};
+
+template <class F, class A>
+using invoke_ok_result_t = typename invoke_ok_result<F, A>::type;
+
+/**
+ * Success type of the Expected returned by map(): lvalue references are kept, so accessors can
+ * be mapped over without copying, everything else is stored by value.
+ */
+template <class R>
+using map_result_t = std::conditional_t<std::is_lvalue_reference_v<R>, R,
+                                        std::remove_cv_t<std::remove_reference_t<R>>>;
+
+/**
+ *
+ * Storage of Expected<T, E> for trivially copyable T and E, where either T or E has niches
+ * behind the storage of the other type. The State is kept in those niches, so the
+ * Expected<T, E> is exactly as big as the union of T and E.
+ *
+ * If `Track` is false, consuming T or E does not change the State.
+ *
+ * As the storage is overwritten when it is consumed, T and E are returned by value.
+ *
+ * The generic and trivial layouts are specializations of this template.
+ */
+template <class T, class E, bool Track, Layout L>
+class ExpectedStorage
+{
+    static_assert(L == Layout::niche_ok || L == Layout::niche_error);
+
+    using Niche = std::conditional_t<L == Layout::niche_ok, NicheState<T, State::ok>,
+                                     NicheState<E, State::error>>;
+
+protected:
+    using ok_type = T;
+    using error_type = E;
+
+    template <class Make>
+    ExpectedStorage(ok_tag, Make&& make) : t_(make())
+    {
+        Niche::store(&t_, State::ok);
+    }
+
+    template <class Make>
+    ExpectedStorage(error_tag, Make&& make) : e_(make())
+    {
+        Niche::store(&t_, State::error);
+    }
+
+    template <class Make>
+    void emplace(ok_tag, Make&& make)
+    {
+        ::new (static_cast<void*>(&t_)) T(make());
+        Niche::store(&t_, State::ok);
+    }
+
+    template <class Make>
+    void emplace(error_tag, Make&& make)
+    {
+        ::new (static_cast<void*>(&e_)) E(make());
+        Niche::store(&t_, State::error);
+    }
+
+    State state() const
+    {
+        return Niche::load(&t_);
+    }
+
+    T take_ok()
+    {
+        T t = t_;
+
+        if constexpr (Track)
+        {
+            Niche::store(&t_, State::ok_moved);
+        }
+        return t;
+    }
+
+    E take_error()
+    {
+        E e = e_;
+
+        if constexpr (Track)
+        {
+            Niche::store(&t_, State::error_moved);
+        }
+        return e;
+    }
+
+    T& ok_ref()
+    {
+        return t_;
+    }
+
+    E& error_ref()
+    {
+        return e_;
+    }
+
+    union
+    {
+        T t_;
+        E e_;
+    };
+};
+
+/**
+ *
+ * Storage of Expected<T, E>, containing the State and the union of T and E.
+ *
+ * This is the generic version for types which are not trivially copyable. It keeps the State
+ * in a separate byte next to the union and manually dispatches moves and destruction to the
+ * alive union member.
+ */
+template <class T, class E, bool Track>
+class ExpectedStorage<T, E, Track, Layout::generic>
+{
+protected:
+    using ok_type = T&&;
+    using error_type = E&&;
+
+    static constexpr bool nothrow_movable =
+        std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_constructible_v<E>;
+
+    template <class Make>
+    ExpectedStorage(ok_tag, Make&& make) : t_(make()), state_(State::ok)
+    {
+    }
+
+    template <class Make>
+    ExpectedStorage(error_tag, Make&& make) : e_(make()), state_(State::error)
+    {
+    }
+
+    /**
+     * No copies, we don't know if the underlying T and E can be copied.
+     */
+    ExpectedStorage(ExpectedStorage&) = delete;
+    ExpectedStorage& operator=(ExpectedStorage&) = delete;
+
+    /**
+     * Moves construct the active member of the other union in place, the payload of `other`
+     * is left in its moved-from state and destroyed together with `other`.
+     */
+    ExpectedStorage(ExpectedStorage&& other) noexcept(nothrow_movable) : state_(other.state_)
+    {
+        construct_from(other);
+
+        if constexpr (Track)
+        {
+            other.state_ = moved(other.state_);
+        }
+    }
+
+    /**
+     * Destroys the current payload and move constructs the payload of `other` in its place, so
+     * T and E do not need to be assignable. As this would leave the storage without a payload if
+     * the move constructor threw, this only exists if the ones of T and E are noexcept.
+     */
+    ExpectedStorage& operator=(
+        move_assignment_arg_t<nothrow_movable, ExpectedStorage> other) noexcept
+    {
+        if (this != &other)
+        {
+            destroy();
+            state_ = other.state_;
+            construct_from(other);
+
+            if constexpr (Track)
+            {
+                other.state_ = moved(other.state_);
+            }
+        }
+        return *this;
+    }
+
+    ~ExpectedStorage()
+    {
+        destroy();
+    }
+
+    void destroy()
+    {
+        if (!is_ok(state_))
+        {
+            e_.~E();
+        }
+        else
+        {
+            t_.~T();
+        }
+    }
+
+    template <class Make>
+    void emplace(ok_tag, Make&& make)
+    {
+        destroy();
+        ::new (static_cast<void*>(&t_)) T(make());
+        state_ = State::ok;
+    }
+
+    template <class Make>
+    void emplace(error_tag, Make&& make)
+    {
+        destroy();
+        ::new (static_cast<void*>(&e_)) E(make());
+        state_ = State::error;
+    }
+
+    State state() const
+    {
+        return state_;
+    }
+
+    T&& take_ok()
+    {
+        if constexpr (Track)
+        {
+            state_ = State::ok_moved;
+        }
+        return std::move(t_);
+    }
+
+    E&& take_error()
+    {
+        if constexpr (Track)
+        {
+            state_ = State::error_moved;
+        }
+        return std::move(e_);
+    }
+
+    /**
+     * Move constructs the payload of `other` into the so far unconstructed union, according
+     * to the already copied State.
+     */
+    void construct_from(ExpectedStorage& other)
+    {
+        if (is_ok(state_))
+        {
+            ::new (static_cast<void*>(&t_)) T(std::move(other.t_));
+        }
+        else
+        {
+            ::new (static_cast<void*>(&e_)) E(std::move(other.e_));
+        }
+    }
+
+    T& ok_ref()
+    {
+        return t_;
+    }
+
+    E& error_ref()
+    {
+        return e_;
+    }
+
+    union
+    {
+        T t_;
+        E e_;
+    };
+
+    State state_;
+};
+
+/**
+ *
+ * Storage of Expected<T, E> for trivially copyable and destructible T and E.
+ *
+ * All special members are defaulted, so the resulting Expected<T, E> is trivially copyable
+ * itself and can be returned in registers.
+ */
+template <class T, class E, bool Track>
+class ExpectedStorage<T, E, Track, Layout::trivial>
+{
+protected:
+    using ok_type = T&&;
+    using error_type = E&&;
+
+    template <class Make>
+    ExpectedStorage(ok_tag, Make&& make) : t_(make()), state_(State::ok)
+    {
+    }
+
+    template <class Make>
+    ExpectedStorage(error_tag, Make&& make) : e_(make()), state_(State::error)
+    {
+    }
+
+    template <class Make>
+    void emplace(ok_tag, Make&& make)
+    {
+        ::new (static_cast<void*>(&t_)) T(make());
+        state_ = State::ok;
+    }
+
+    template <class Make>
+    void emplace(error_tag, Make&& make)
+    {
+        ::new (static_cast<void*>(&e_)) E(make());
+        state_ = State::error;
+    }
+
+    State state() const
+    {
+        return state_;
+    }
+
+    T&& take_ok()
+    {
+        if constexpr (Track)
+        {
+            state_ = State::ok_moved;
+        }
+        return std::move(t_);
+    }
+
+    E&& take_error()
+    {
+        if constexpr (Track)
+        {
+            state_ = State::error_moved;
+        }
+        return std::move(e_);
+    }
+
+    T& ok_ref()
+    {
+        return t_;
+    }
+
+    E& error_ref()
+    {
+        return e_;
+    }
+
+    union
+    {
+        T t_;
+        E e_;
+    };
+
+    State state_;
+};
+
+/**
+ *
+ * Storage of Expected<T, E> for T = std::size_t and an E with errno_word_traits: the success
+ * object and the negated errno share a single ssize_t, the moved out states use the two smallest
+ * values, which are neither. Success objects have to be in 0..SSIZE_MAX, checked policies abort
+ * on larger ones instead of turning them into errors.
+ *
+ * Success and error objects are returned by value and can not be referenced in place, so
+ * emplace_ok() and emplace_error() return copies.
+ */
+template <class T, class E, bool Track>
+class ExpectedStorage<T, E, Track, Layout::errno_word>
+{
+    using Word = std::make_signed_t<std::size_t>;
+    using Traits = errno_word_traits<E>;
+
+    static constexpr Word ok_moved_word = std::numeric_limits<Word>::min();
+    static constexpr Word error_moved_word = ok_moved_word + 1;
+
+protected:
+    using ok_type = T;
+    using error_type = E;
+
+    template <class Make>
+    ExpectedStorage(ok_tag, Make&& make) : word_(to_word(make()))
+    {
+    }
+
+    template <class Make>
+    ExpectedStorage(error_tag, Make&& make) : word_(-static_cast<Word>(Traits::to_errno(make())))
+    {
+    }
+
+    template <class Make>
+    void emplace(ok_tag, Make&& make)
+    {
+        word_ = to_word(make());
+    }
+
+    template <class Make>
+    void emplace(error_tag, Make&& make)
+    {
+        word_ = -static_cast<Word>(Traits::to_errno(make()));
+    }
+
+    State state() const
+    {
+        if (word_ >= 0)
+        {
+            return State::ok;
+        }
+        if (word_ == ok_moved_word)
+        {
+            return State::ok_moved;
+        }
+        if (word_ == error_moved_word)
+        {
+            return State::error_moved;
+        }
+        return State::error;
+    }
+
+    T take_ok()
+    {
+        T t = ok_ref();
+
+        if constexpr (Track)
+        {
+            word_ = ok_moved_word;
+        }
+        return t;
+    }
+
+    E take_error()
+    {
+        E e = error_ref();
+
+        if constexpr (Track)
+        {
+            word_ = error_moved_word;
+        }
+        return e;
+    }
+
+    T ok_ref() const
+    {
+        return static_cast<T>(word_);
+    }
+
+    E error_ref() const
+    {
+        return Traits::from_errno(static_cast<int>(-word_));
+    }
+
+private:
+    static Word to_word(T t)
+    {
+        if constexpr (Track)
+        {
+            if (BOWL_UNLIKELY(t > static_cast<T>(std::numeric_limits<Word>::max())))
+            {
+                abort_with("success object of a one word Expected<size_t, E> is above SSIZE_MAX");
+            }
+        }
+        return static_cast<Word>(t);
+    }
+
+    Word word_;
+};
+
+template <class T, class E, class Policy>
+using expected_storage_t =
+    ExpectedStorage<typename OkStorage<T>::type, E, Policy::checked,
+                    expected_layout_v<typename OkStorage<T>::type, E, Policy>>;
+
+} // namespace detail
+
+/**
+ *
+ * Expected<T, E>: a container which can either contain a success object of type T or an
+ * error object of type E.
+ *
+ * E has to be usable as an error through error_traits<E>, see is_error_v.
+ *
+ * If both T and E are trivially copyable and trivially destructible, so is Expected<T, E>.
+ * Copying or moving such an Expected does not mark the source as moved out, as it
+ * still holds a valid copy of the contents.
+ *
+ * The ok/error/moved out state takes up a single byte behind the union of T and E, or
+ * no space at all if T or E provide niches, see niche_traits.
+ *
+ * Policy decides how misuse is handled, see policy::Throw, policy::Abort and
+ * policy::Unchecked.
+ *
+ * T can also be
+ *
+ * - an lvalue reference `U&`, which is stored as a pointer to U and unpacked as U&, so
+ *   lookups can hand out elements without copying them.
+ * - void, for operations which give back nothing but might fail. Expected<void, E> converts
+ *   from and to MaybeError<E>.
+ */
+template <class T, class E, class Policy>
+class Expected : private detail::expected_storage_t<T, E, Policy>
+{
+    using Storage = detail::expected_storage_t<T, E, Policy>;
+    using Ok = detail::OkStorage<T>;
+
+    using typename Storage::error_type;
+    using ok_type = std::conditional_t<std::is_object_v<T>, typename Storage::ok_type, T>;
+
+    static_assert(is_error_v<E>, "E has to be an error type, see bowl::error_traits");
+    static_assert(!std::is_rvalue_reference_v<T>, "Expected can not hold rvalue references");
+
+public:
+    /**
+     *
+     * Constructs a Expected from Unexpected<E>, consuming it.
+     *
+     * This is used for returning the error case:
+     *
+     * Expected<OkCase, ErrorCase> foobar()
+     * {
+     *     return Unexpected(ErrorCase("I'm an error!");
+     * }
+     */
+    Expected(Unexpected<E, Policy>&& e) : Storage(detail::error_tag{}, [&] { return e.unpack(); })
+    {
+    }
+
+    /**
+     *
+     * Constructs a Expected from an Unexpected<E> with a different Policy.
+     */
+    template <class P>
+    Expected(Unexpected<E, P>&& e) : Storage(detail::error_tag{}, [&] { return e.unpack(); })
+    {
+    }
+
+    /**
+     *
+     * Construct an Expected from T, consuming (->moving) it.
+     *
+     * This is used for the success case.
+     */
+    Expected(typename Ok::param_type t)
+    : Storage(detail::ok_tag{}, [&] { return Ok::make(std::forward<typename Ok::param_type>(t)); })
+    {
+    }
+
+    /**
+     * An Expected<U&, E> only refers to lvalues. A temporary, or an object converted to one,
+     * would be gone by the time the Expected is used.
+     */
+    template <class X = T, std::enable_if_t<std::is_reference_v<X>, int> = 0>
+    Expected(std::remove_reference_t<X>&& t) = delete;
+
+    /**
+     *
+     * Construct an ok() Expected<void, E>.
+     */
+    template <class X = T, std::enable_if_t<std::is_void_v<X>, int> = 0>
+    Expected() : Storage(detail::ok_tag{}, [] { return Ok::make(); })
+    {
+    }
+
+    /**
+     *
+     * Construct an Expected<void, E> from a MaybeError<E>, consuming it.
+     */
+    template <class P, class X = T, std::enable_if_t<std::is_void_v<X>, int> = 0>
+    Expected(MaybeError<E, P>&& err) : Storage(detail::ok_tag{}, [] { return Ok::make(); })
+    {
+        if (!err.ok())
+        {
+            this->emplace(detail::error_tag{}, [&] { return err.unpack_error(); });
+        }
+    }
+
+    /**
+     *
+     * Construct the success object of type T in place from `args`.
+     *
+     * T does not have to be movable for this:
+     *
+     * Expected<std::mutex, ErrorCase> foobar()
+     * {
+     *     return { std::in_place };
+     * }
+     */
+    template <class... Args, class X = T,
+              std::enable_if_t<detail::OkStorage<X>::template constructible<Args...>(), int> = 0>
+    Expected(std::in_place_t, Args&&... args)
+    : Storage(detail::ok_tag{}, [&] { return Ok::make(std::forward<Args>(args)...); })
+    {
+    }
+
+    /**
+     *
+     * Construct the error object of type E in place from `args`.
+     *
+     * This saves the moves of E into and out of an Unexpected<E>:
+     *
+     * Expected<OkCase, ErrorCase> foobar()
+     * {
+     *     return { bowl::unexpect, "I'm an error!" };
+     * }
+     */
+    template <class... Args, std::enable_if_t<std::is_constructible_v<E, Args...>, int> = 0>
+    Expected(unexpect_t, Args&&... args)
+    : Storage(detail::error_tag{}, [&] { return E(std::forward<Args>(args)...); })
+    {
+    }
+
+    bool ok()
+    {
+        return detail::is_ok(this->state());
+    }
+
+    /**
+     *
+     * True if unpack_ok() would succeed, i.e. this Expected is ok() and has not been unpacked
+     * yet. This checks the state only once, CHECK_ASSIGN uses it so that its success path
+     * compiles down to a single compare.
+     */
+    bool can_unpack_ok()
+    {
+        if constexpr (Policy::checked)
+        {
+            return this->state() == detail::State::ok;
+        }
+        else
+        {
+            return ok();
+        }
+    }
+
+    /**
+     *
+     * Return the success object if this Expected is ok()
+     *
+     * Returns T by value instead of T&& if the state of this Expected is kept in the niches
+     * of T or E. Returns U& for Expected<U&, E> and nothing for Expected<void, E>.
+     *
+     * Throws MovedOutException if object has already been unpacked.
+     * Throws FalseStateException if this Expected contains an error.
+     */
+    ok_type unpack_ok()
+    {
+        if constexpr (Policy::checked)
+        {
+            if (BOWL_UNLIKELY(!can_unpack_ok()))
+            {
+                unpack_ok_failed();
+            }
+        }
+
+        return take_value();
+    }
+
+    /**
+     *
+     * Return the failure object if this Expected is !ok()
+     *
+     * Returns E by value instead of E&& if the state of this Expected is kept in the niches
+     * of T or E.
+     *
+     * Throws MovedOutException if object has already been unpacked.
+     * Throws FalseStateException if this Expected contains a success.
+     */
+    error_type unpack_error()
+    {
+        if constexpr (Policy::checked)
+        {
+            if (BOWL_UNLIKELY(this->state() != detail::State::error))
+            {
+                unpack_error_failed();
+            }
+        }
+
+        return this->take_error();
+    }
+
     /**
      *
-     * Constructs a Expected from Unexpected<E>, consuming it.
+     * If this Expected is !ok(), throw the contained Error
+     * via its throw_as_exception() method.
      *
-     * This is used for returning the error case:
+     * If this Expected is ok(), do nothing.
      *
-     * Expected<OkCase, ErrorCase> foobar()
-     * {
-     *     return Unexpected(ErrorCase("I'm an error!");
-     * }
+     * Throws MovedOutException if this Expected has already succesfully
+     * been unpacked.
      */
-    Expected(Unexpected<E>&& e) : ok_(false), e_(std::move(e.unpack())), is_moved_(false)
+    void throw_if_error()
     {
+        if (BOWL_UNLIKELY(!ok()))
+        {
+            throw_error();
+        }
     }
 
     /**
      *
-     * Construct an Expected from T, consuming (->moving) it.
+     * Destroys the current contents and constructs a new success object in place from `args`.
+     * Afterwards, this Expected is ok() and can be unpacked again.
      *
-     * This is used for the success case.
+     * If constructing T from `args` can throw, T is constructed first and then moved in,
+     * so this Expected is never left without contents.
      */
-    Expected(T&& t) : ok_(true), t_(std::move(t)), is_moved_(false)
+    template <class... Args>
+    decltype(auto) emplace_ok(Args&&... args)
     {
+        if constexpr (!std::is_object_v<T> || std::is_nothrow_constructible_v<T, Args...>)
+        {
+            this->emplace(detail::ok_tag{}, [&] { return Ok::make(std::forward<Args>(args)...); });
+        }
+        else
+        {
+            static_assert(std::is_nothrow_move_constructible_v<T>,
+                          "emplace_ok() needs either a noexcept constructor or move constructor");
+
+            T tmp(std::forward<Args>(args)...);
+            this->emplace(detail::ok_tag{}, [&] { return std::move(tmp); });
+        }
+
+        if constexpr (std::is_lvalue_reference_v<T>)
+        {
+            return *this->ok_ref();
+        }
+        else if constexpr (std::is_object_v<T>)
+        {
+            return this->ok_ref();
+        }
     }
 
     /**
-     * No copies, we don't know if the underlying T and E can be copied.
+     *
+     * Destroys the current contents and constructs a new error object in place from `args`.
+     * Afterwards, this Expected is !ok() and can be unpacked again.
+     */
+    template <class... Args>
+    decltype(auto) emplace_error(Args&&... args)
+    {
+        if constexpr (std::is_nothrow_constructible_v<E, Args...>)
+        {
+            this->emplace(detail::error_tag{}, [&] { return E(std::forward<Args>(args)...); });
+        }
+        else
+        {
+            static_assert(std::is_nothrow_move_constructible_v<E>,
+                          "emplace_error() needs either a noexcept constructor or move constructor");
+
+            E tmp(std::forward<Args>(args)...);
+            this->emplace(detail::error_tag{}, [&] { return std::move(tmp); });
+        }
+        return this->error_ref();
+    }
+
+    /**
+     *
+     * Combinators
+     *
+     * All combinators consume this Expected, just like unpack_ok() and unpack_error(),
+     * and build their result directly in the storage of the returned object. The contents
+     * of this Expected are passed to `f` as rvalues, so the only moves happening are the
+     * ones `f` itself does, plus one move of whichever of T or E is passed through
+     * unchanged.
+     *
+     * For Expected<void, E>, `f` is called without arguments instead of with the success object.
      */
-    Expected(Expected<T, E>&) = delete;
-    Expected<T, E>& operator=(Expected<T, E>&) = delete;
 
-    Expected(Expected<T, E>&& other)
+    /**
+     *
+     * If ok(), returns Expected<U, E>, containing f(T) with U being the return type of f.
+     * If f returns an lvalue reference, so does the result. Otherwise passes the error on.
+     */
+    template <class F>
+    auto map(F&& f) &&
     {
-        this->is_moved_ = other.is_moved_;
+        using U = detail::map_result_t<detail::invoke_ok_result_t<F, ok_type>>;
+        using R = Expected<U, E, Policy>;
 
-        if (!other.is_moved_)
+        check_if_moved();
+
+        if (BOWL_LIKELY(ok()))
         {
-            if (other.ok_)
-            {
-                this->t_ = std::move(other.t_);
-            }
-            else
-            {
-                this->e_ = std::move(other.e_);
-            }
+            return R(detail::ok_tag{},
+                     [&]() -> decltype(auto) { return invoke_with_value(std::forward<F>(f)); });
         }
+        return R(detail::error_tag{}, [&] { return this->take_error(); });
+    }
 
-        this->ok_ = other.ok_;
-        other.is_moved_ = true;
+    template <class F>
+    auto map(F&& f) &
+    {
+        return std::move(*this).map(std::forward<F>(f));
     }
 
-    Expected<T, E>& operator=(Expected<T, E>&& other)
+    /**
+     *
+     * If ok(), returns f(T), which has to return an Expected<U, E>.
+     * Otherwise passes the error on.
+     */
+    template <class F>
+    auto and_then(F&& f) &&
     {
-        this->is_moved_ = other.is_moved_;
+        using R = detail::invoke_ok_result_t<F, ok_type>;
+
+        check_if_moved();
 
-        if (!other.is_moved_)
+        if (BOWL_LIKELY(ok()))
         {
-            if (other.ok_)
-            {
-                this->t_ = std::move(other.t_);
-            }
-            else
-            {
-                this->e_ = std::move(other.e_);
-            }
+            return invoke_with_value(std::forward<F>(f));
         }
+        return R(detail::error_tag{}, [&] { return this->take_error(); });
+    }
 
-        this->ok_ = other.ok_;
+    template <class F>
+    auto and_then(F&& f) &
+    {
+        return std::move(*this).and_then(std::forward<F>(f));
+    }
 
-        other.is_moved_ = true;
-        return *this;
+    /**
+     *
+     * If !ok(), returns f(E), which has to return an Expected<T, E2>.
+     * Otherwise passes the success object on.
+     */
+    template <class F>
+    auto or_else(F&& f) &&
+    {
+        using R = std::invoke_result_t<F, error_type>;
+
+        check_if_moved();
+
+        if (BOWL_LIKELY(ok()))
+        {
+            return R(detail::ok_tag{}, [&]() -> ok_type { return take_value(); });
+        }
+        return detail::invoke(std::forward<F>(f), this->take_error());
     }
 
-    bool ok()
+    template <class F>
+    auto or_else(F&& f) &
     {
-        return ok_;
+        return std::move(*this).or_else(std::forward<F>(f));
     }
 
     /**
      *
-     * Return the success object if this Expected is ok()
-     *
-     * Throws MovedOutException if object has already been unpacked.
-     * Throws FalseStateException if this Expected contains an error.
+     * If !ok(), returns Expected<T, E2>, containing f(E) with E2 being the return type of f.
+     * Otherwise passes the success object on.
      */
-    T&& unpack_ok()
+    template <class F>
+    auto map_error(F&& f) &&
     {
+        using E2 = std::remove_cv_t<std::remove_reference_t<std::invoke_result_t<F, error_type>>>;
+        using R = Expected<T, E2, Policy>;
+
         check_if_moved();
 
-        if (!ok_)
+        if (BOWL_LIKELY(ok()))
         {
-            throw UnpackOkIfErrorException(e_);
+            return R(detail::ok_tag{}, [&]() -> ok_type { return take_value(); });
         }
+        return R(detail::error_tag{},
+                 [&] { return detail::invoke(std::forward<F>(f), this->take_error()); });
+    }
 
-        is_moved_ = true;
-        return std::move(t_);
+    template <class F>
+    auto map_error(F&& f) &
+    {
+        return std::move(*this).map_error(std::forward<F>(f));
     }
 
     /**
      *
-     * Return the failure object if this Expected is !ok()
+     * If !ok(), returns Expected<T, Contextual<E>> with a context frame formatted from `fmt` and
+     * `args` added to the error, see bowl/context.hpp, which has to be included to use this.
+     * Otherwise passes the success object on.
+     */
+    template <class... Args>
+    auto with_context(const char* fmt, const Args&... args) &&;
+
+    template <class... Args>
+    auto with_context(const char* fmt, const Args&... args) &
+    {
+        return std::move(*this).with_context(fmt, args...);
+    }
+
+    /**
      *
-     * Throws MovedOutException if object has already been unpacked.
-     * Throws FalseStateException if this Expected contains a success.
+     * Returns the success object if ok(), or `fallback` converted to T otherwise.
      */
-    E&& unpack_error()
+    template <class U>
+    T value_or(U&& fallback) &&
     {
         check_if_moved();
 
-        if (ok_)
+        if (BOWL_LIKELY(ok()))
         {
-            throw UnpackErrorIfOkException();
+            return take_value();
         }
 
-        is_moved_ = true;
-        return std::move(e_);
+        this->take_error();
+        return static_cast<T>(std::forward<U>(fallback));
+    }
+
+    template <class U>
+    T value_or(U&& fallback) &
+    {
+        return std::move(*this).value_or(std::forward<U>(fallback));
     }
 
     /**
      *
-     * If this Expected is !ok(), throw the contained Error
-     * via its throw_as_exception() method.
-     *
-     * If this Expected is ok(), do nothing.
-     *
-     * Throws MovedOutException if this Expected has already succesfully
-     * been unpacked.
+     * Returns the success object if ok(). Otherwise returns f(E), or f() if f does not take
+     * the error, so the fallback is only computed when it is needed.
      */
-    void throw_if_error()
+    template <class F>
+    T value_or_else(F&& f) &&
     {
-        if (!ok_)
+        check_if_moved();
+
+        if (BOWL_LIKELY(ok()))
+        {
+            return take_value();
+        }
+
+        if constexpr (std::is_invocable_v<F, error_type>)
+        {
+            return detail::invoke(std::forward<F>(f), this->take_error());
+        }
+        else
         {
-            check_if_moved();
+            this->take_error();
+            return detail::invoke(std::forward<F>(f));
+        }
+    }
+
+    template <class F>
+    T value_or_else(F&& f) &
+    {
+        return std::move(*this).value_or_else(std::forward<F>(f));
+    }
+
+private:
+    template <class, class, class>
+    friend class Expected;
+
+    template <class, class>
+    friend class MaybeError;
+
+    /**
+     * Constructs T or E directly in the storage from the return value of `make()`.
+     * For the success object, `make()` returns a T, a U& for Expected<U&, E> or nothing
+     * for Expected<void, E>.
+     */
+    template <class Make>
+    Expected(detail::ok_tag tag, Make&& make) : Storage(tag, [&] { return Ok::store(make); })
+    {
+    }
+
+    template <class Make>
+    Expected(detail::error_tag tag, Make&& make) : Storage(tag, std::forward<Make>(make))
+    {
+    }
 
-            is_moved_ = true;
-            e_.throw_as_exception();
+    /**
+     * Consumes the success object, turning the stored pointer of Expected<U&, E> back into U&.
+     */
+    ok_type take_value()
+    {
+        if constexpr (std::is_void_v<T>)
+        {
+            this->take_ok();
+        }
+        else if constexpr (std::is_lvalue_reference_v<T>)
+        {
+            return *this->take_ok();
+        }
+        else
+        {
+            return this->take_ok();
         }
     }
 
-    ~Expected()
+    template <class F>
+    decltype(auto) invoke_with_value(F&& f)
     {
-        if (!ok_)
+        if constexpr (std::is_void_v<T>)
         {
-            e_.~E();
+            this->take_ok();
+            return detail::invoke(std::forward<F>(f));
         }
         else
         {
-            t_.~T();
+            return detail::invoke(std::forward<F>(f), take_value());
         }
     }
 
-private:
     void check_if_moved()
     {
-
-        if (is_moved_)
+        if constexpr (Policy::checked)
         {
-            throw MovedOutException();
+            if (BOWL_UNLIKELY(detail::is_moved(this->state())))
+            {
+                Policy::moved_out();
+            }
         }
     }
 
-    bool ok_;
+    /**
+     * The error paths, kept out of line so that building the exceptions is not inlined into
+     * every caller.
+     */
+    [[noreturn]] BOWL_COLD void unpack_ok_failed()
+    {
+        check_if_moved();
+        Policy::unpack_ok_if_error(this->error_ref());
+    }
+
+    [[noreturn]] BOWL_COLD void unpack_error_failed()
+    {
+        check_if_moved();
+        Policy::unpack_error_if_ok();
+    }
 
-    union
+    BOWL_COLD void throw_error()
     {
-        T t_;
-        E e_;
-    };
+        check_if_moved();
+
+        auto&& e = this->take_error();
+        error_traits<E>::throw_as_exception(e);
+    }
+};
+
+/**
+ *
+ * A reference to a T that can be copied around, like std::reference_wrapper<T>, without
+ * needing <functional>. BOWL_TRY yields it for Expected<T&, E>.
+ */
+template <class T>
+class Ref
+{
+public:
+    Ref(T& ref) : ptr_(detail::address_of(ref))
+    {
+    }
+
+    operator T&() const
+    {
+        return *ptr_;
+    }
+
+    T& get() const
+    {
+        return *ptr_;
+    }
+
+private:
+    T* ptr_;
+};
+
+namespace detail
+{
+
+/**
+ * The error type E of an Expected or MaybeError.
+ */
+template <class R>
+struct error_of;
+
+template <class T, class E, class Policy>
+struct error_of<Expected<T, E, Policy>>
+{
+    using type = E;
+};
+
+template <class E, class Policy>
+struct error_of<MaybeError<E, Policy>>
+{
+    using type = E;
+};
+
+/**
+ * True if CHECK_ASSIGN and BOWL_TRY have to return the error of `exp`.
+ */
+template <class T, class E, class Policy>
+bool must_propagate(Expected<T, E, Policy>& exp)
+{
+    return !exp.can_unpack_ok();
+}
+
+template <class E, class Policy>
+bool must_propagate(MaybeError<E, Policy>& me);
+
+/**
+ * Unpacks the success object for CHECK_ASSIGN: T by value, U& for Expected<U&, E> and a Unit
+ * for Expected<void, E> and MaybeError<E>, so that the assigned variable always has a valid type.
+ */
+template <class T, class E, class Policy>
+std::conditional_t<std::is_void_v<T>, Unit, T> unpack_assign(Expected<T, E, Policy>& exp)
+{
+    if constexpr (std::is_void_v<T>)
+    {
+        exp.unpack_ok();
+        return {};
+    }
+    else
+    {
+        return exp.unpack_ok();
+    }
+}
+
+template <class E, class Policy>
+Unit unpack_assign(MaybeError<E, Policy>& me);
+
+/**
+ * Unpacks the success object for BOWL_TRY. Like unpack_assign(), but references are wrapped into
+ * a Ref, as a statement expression always yields its value by copy.
+ */
+template <class Source>
+auto try_value(Source& src)
+{
+    using R = decltype(unpack_assign(src));
+
+    if constexpr (std::is_lvalue_reference_v<R>)
+    {
+        return Ref<std::remove_reference_t<R>>(unpack_assign(src));
+    }
+    else
+    {
+        return unpack_assign(src);
+    }
+}
+
+/**
+ * Returned by CHECK_ASSIGN and BOWL_TRY on the error path. It converts into the return type R of
+ * the enclosing function, an Expected or MaybeError, by constructing R's error in place from the
+ * unpacked error of `Source`, through error_conversion if the error types differ.
+ *
+ * The conversion is cold and out of line, so the error path costs the caller a single call.
+ * Small trivially copyable sources are held by value, which keeps them in registers. Larger ones
+ * are held by reference, copying them would only add a block copy to every propagating frame.
+ */
+template <class Source>
+class PropagateError
+{
+    using Held = std::conditional_t<
+        std::is_trivially_copyable_v<Source> && sizeof(Source) <= 2 * sizeof(void*), Source,
+        Source&>;
+    using From = typename error_of<Source>::type;
+
+public:
+    explicit PropagateError(Source& src) : src_(src)
+    {
+    }
 
-    bool is_moved_;
+    template <class R>
+    BOWL_COLD operator R()
+    {
+        using To = typename error_of<R>::type;
+
+        if constexpr (std::is_same_v<From, To>)
+        {
+            return R(unexpect, src_.unpack_error());
+        }
+        else
+        {
+            static_assert(is_error_convertible<From, To>::value,
+                          "the error can not be converted into the error type of the enclosing "
+                          "function, specialize bowl::error_conversion");
+
+            return R(unexpect, error_conversion<From, To>::convert(src_.unpack_error()));
+        }
+    }
+
+private:
+    Held src_;
 };
+
+/**
+ * Stands in for BOWL_TRY on compilers without statement expressions.
+ */
+template <class Source>
+void try_unsupported()
+{
+    static_assert(sizeof(Source) == 0,
+                  "BOWL_TRY needs GNU statement expressions, use CHECK_ASSIGN instead");
+}
+
+} // namespace detail
 } // namespace bowl
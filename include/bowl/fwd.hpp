@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <bowl/config.hpp>
+
+/**
+ *
+ * Forward declarations of all bowl types, for headers which only mention them in declarations,
+ * e.g. as return types of functions defined elsewhere:
+ *
+ *     #include <bowl/fwd.hpp>
+ *
+ *     bowl::Expected<Config, bowl::ErrnoError> load_config(const char* path);
+ *
+ * This header does not include any standard header, so it costs next to nothing per translation
+ * unit. Only translation units which create, inspect or unpack the types need their full
+ * headers. The default template arguments are declared here.
+ */
+namespace bowl
+{
+
+namespace policy
+{
+#ifndef BOWL_NO_EXCEPTIONS
+struct Throw;
+#endif
+struct Abort;
+struct Unchecked;
+} // namespace policy
+
+#ifdef BOWL_NO_EXCEPTIONS
+using DefaultPolicy = policy::Abort;
+#else
+using DefaultPolicy = policy::Throw;
+#endif
+
+template <class T, class E, class Policy = DefaultPolicy>
+class Expected;
+
+template <class E, class Policy = DefaultPolicy>
+class MaybeError;
+
+template <class E, class Policy = DefaultPolicy>
+class Unexpected;
+
+template <class T>
+class Ref;
+
+template <class E>
+struct error_traits;
+
+template <class From, class To>
+struct error_conversion;
+
+template <class X>
+struct niche_traits;
+
+template <class E>
+struct errno_word_traits;
+
+enum class Errno : int;
+
+class Error;
+
+template <class E>
+class ErrorAdapter;
+
+class ErrnoError;
+class CustomError;
+class FormattedError;
+class CatalogError;
+class AnyError;
+
+template <class... Es>
+class ErrorSet;
+
+template <class E>
+class Contextual;
+
+class MappedFile;
+
+} // namespace bowl
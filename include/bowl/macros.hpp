@@ -2,11 +2,43 @@
 
 #pragma once
 
+#include <bowl/config.hpp>
+
 // poor mans rust ?
 #define CHECK_ASSIGN(var, stmt)                                                                    \
     auto var##_res = stmt;                                                                         \
-    if (!var##_res.ok())                                                                           \
+    if (BOWL_UNLIKELY(bowl::detail::must_propagate(var##_res)))                                    \
     {                                                                                              \
-        return bowl::Unexpected(var##_res.unpack_error());                                         \
+        return bowl::detail::PropagateError<decltype(var##_res)>(var##_res);                       \
     }                                                                                              \
-    auto var = var##_res.unpack_ok();
+    [[maybe_unused]] decltype(auto) var = bowl::detail::unpack_assign(var##_res);
+
+/**
+ * BOWL_TRY(expr): evaluates to the success object of the Expected `expr`, or returns its error
+ * from the enclosing function, which has to return an Expected or a MaybeError.
+ *
+ *     Expected<Header, ErrnoError> read_header(int fd)
+ *     {
+ *         return parse_header(BOWL_TRY(read_block(fd, 0)));
+ *     }
+ *
+ * The success object is moved exactly once. Expected<U&, E> yields a bowl::Ref<U>,
+ * Expected<void, E> and MaybeError<E> a unit value. The error is converted through
+ * bowl::error_conversion if the error types differ.
+ *
+ * BOWL_TRY needs GNU statement expressions (GCC and Clang), elsewhere use CHECK_ASSIGN.
+ */
+#ifdef BOWL_HAS_STATEMENT_EXPRESSIONS
+#define BOWL_TRY(expr)                                                                             \
+    __extension__({                                                                                \
+        auto&& bowl_try_res_ = (expr);                                                             \
+        if (BOWL_UNLIKELY(bowl::detail::must_propagate(bowl_try_res_)))                            \
+        {                                                                                          \
+            return bowl::detail::PropagateError<std::remove_reference_t<decltype(bowl_try_res_)>>( \
+                bowl_try_res_);                                                                    \
+        }                                                                                          \
+        bowl::detail::try_value(bowl_try_res_);                                                    \
+    })
+#else
+#define BOWL_TRY(expr) bowl::detail::try_unsupported<decltype(expr)>()
+#endif
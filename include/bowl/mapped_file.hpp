@@ -0,0 +1,201 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <bowl/error.hpp>
+#include <bowl/expected.hpp>
+#include <bowl/maybe_error.hpp>
+#include <bowl/sys.hpp>
+
+#include <cstddef>
+#include <string_view>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace bowl
+{
+
+/**
+ *
+ * MappedFile: a read-only, private memory mapping of a whole file.
+ *
+ * MappedFile::open() opens, maps and closes the file again, reporting any failure as
+ * ErrnoError, so loading a file never throws. The mapping is released when the MappedFile
+ * is destroyed. Empty files are represented without a mapping.
+ *
+ * auto file = MappedFile::open("table.bin", { MappedFile::Access::sequential });
+ * if (file.ok())
+ * {
+ *     parse(file.unpack_ok().view());
+ * }
+ */
+class MappedFile
+{
+public:
+    /**
+     * Access pattern, passed to the kernel via madvise() to tune readahead.
+     */
+    enum class Access
+    {
+        normal,
+        sequential,
+        random,
+    };
+
+    struct Options
+    {
+        Access access = Access::normal;
+        /**
+         * Prefault all pages with MAP_POPULATE, so that accessing the contents never page faults.
+         */
+        bool populate = false;
+        /**
+         * Ask for transparent huge pages. This is only a hint, it is silently ignored if the
+         * kernel or the filesystem does not support huge pages for file mappings.
+         */
+        bool huge_pages = false;
+    };
+
+    static Expected<MappedFile, ErrnoError> open(const char* path)
+    {
+        return open(path, Options());
+    }
+
+    static Expected<MappedFile, ErrnoError> open(const char* path, Options opts)
+    {
+        auto opened = sys::open(path, O_RDONLY | O_CLOEXEC);
+        if (!opened.ok())
+        {
+            return Unexpected(opened.unpack_error());
+        }
+
+        int fd = opened.unpack_ok();
+        auto st = sys::fstat(fd);
+        if (!st.ok())
+        {
+            sys::close(fd);
+            return Unexpected(st.unpack_error());
+        }
+
+        std::size_t size = static_cast<std::size_t>(st.unpack_ok().st_size);
+        if (size == 0)
+        {
+            sys::close(fd);
+            return MappedFile(nullptr, 0);
+        }
+
+        int flags = MAP_PRIVATE | (opts.populate ? MAP_POPULATE : 0);
+        auto mem = sys::mmap(nullptr, size, PROT_READ, flags, fd, 0);
+
+        // the mapping keeps its own reference to the file
+        sys::close(fd);
+
+        if (!mem.ok())
+        {
+            return Unexpected(mem.unpack_error());
+        }
+
+        MappedFile file(mem.unpack_ok(), size);
+
+        if (opts.huge_pages)
+        {
+            sys::madvise(file.data_, size, MADV_HUGEPAGE);
+        }
+
+        if (opts.access != Access::normal)
+        {
+            auto advised = file.advise(opts.access);
+            if (!advised.ok())
+            {
+                return Unexpected(advised.unpack_error());
+            }
+        }
+        return file;
+    }
+
+    MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0))
+    {
+    }
+
+    MappedFile& operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            unmap();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+        }
+        return *this;
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+        unmap();
+    }
+
+    /**
+     * Change the access pattern hint for the whole file.
+     */
+    MaybeError<ErrnoError> advise(Access access)
+    {
+        if (data_ == nullptr)
+        {
+            return {};
+        }
+
+        int advice = access == Access::sequential ? MADV_SEQUENTIAL
+                     : access == Access::random   ? MADV_RANDOM
+                                                  : MADV_NORMAL;
+        return sys::madvise(data_, size_, advice);
+    }
+
+    const unsigned char* data() const
+    {
+        return static_cast<const unsigned char*>(data_);
+    }
+
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+    const unsigned char* begin() const
+    {
+        return data();
+    }
+
+    const unsigned char* end() const
+    {
+        return data() + size_;
+    }
+
+    std::string_view view() const
+    {
+        return { static_cast<const char*>(data_), size_ };
+    }
+
+private:
+    MappedFile(void* data, std::size_t size) : data_(data), size_(size)
+    {
+    }
+
+    void unmap()
+    {
+        if (data_ != nullptr)
+        {
+            sys::munmap(data_, size_);
+        }
+    }
+
+    void* data_;
+    std::size_t size_;
+};
+
+} // namespace bowl
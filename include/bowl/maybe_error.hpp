@@ -2,9 +2,16 @@
 
 #pragma once
 
+#include <bowl/error_traits.hpp>
 #include <bowl/exception.hpp>
+#include <bowl/expected.hpp>
+#include <bowl/fwd.hpp>
+#include <bowl/policy.hpp>
 #include <bowl/unexpected.hpp>
 
+#include <type_traits>
+#include <utility>
+
 namespace bowl
 {
 
@@ -12,53 +19,62 @@ namespace bowl
  *
  * MaybeError<E>: either indicates ok() with no further information or !ok(),
  * and contains an Error object of type E for more information.
+ *
+ * If E is trivially copyable and trivially destructible, so is MaybeError<E>.
+ *
+ * Policy decides how misuse is handled, see policy::Throw, policy::Abort and
+ * policy::Unchecked.
  */
-template <class E>
+template <class E, class Policy>
 class MaybeError
+: private detail::ErrorStorage<E, Policy::checked, detail::maybe_error_layout_v<E, Policy>>
 {
+    using Storage =
+        detail::ErrorStorage<E, Policy::checked, detail::maybe_error_layout_v<E, Policy>>;
+
+    using typename Storage::error_type;
+
+    static_assert(is_error_v<E>, "E has to be an error type, see bowl::error_traits");
+
 public:
-    MaybeError(E&& e) : ok_(false), is_moved_(false), e_(std::move(e))
+    MaybeError(E&& e) : Storage(detail::error_tag{}, [&] { return std::move(e); })
     {
     }
 
-    MaybeError(Unexpected<E>&& e) : ok_(false), is_moved_(false), e_(std::move(e.unpack()))
+    template <class P>
+    MaybeError(Unexpected<E, P>&& e) : Storage(detail::error_tag{}, [&] { return e.unpack(); })
     {
     }
 
-    MaybeError() : ok_(true), is_moved_(false)
+    MaybeError() : Storage()
     {
     }
 
-    MaybeError(MaybeError<E>&) = delete;
-    MaybeError<E>& operator=(MaybeError<E>&) = delete;
-
-    MaybeError(MaybeError<E>&& other)
+    /**
+     *
+     * Construct a MaybeError<E> from an Expected<void, E>, consuming it.
+     */
+    template <class P>
+    MaybeError(Expected<void, E, P>&& exp) : Storage()
     {
-        this->ok_ = other.ok_;
-
-        this->is_moved_ = other.is_moved_;
-
-        if (!other.is_moved_)
+        if (exp.ok())
         {
-            this->e_ = std::move(other.e_);
+            exp.unpack_ok();
         }
-
-        other.is_moved_ = true;
-    }
-
-    MaybeError& operator=(MaybeError<E>&& other)
-    {
-        this->ok_ = other.ok_;
-
-        this->is_moved_ = other.is_moved_;
-
-        if (!other.is_moved_)
+        else
         {
-            this->e_ = std::move(other.e_);
+            this->emplace(detail::error_tag{}, [&] { return exp.unpack_error(); });
         }
-        other.is_moved_ = true;
+    }
 
-        return *this;
+    /**
+     *
+     * Construct the error object of type E in place from `args`.
+     */
+    template <class... Args, std::enable_if_t<std::is_constructible_v<E, Args...>, int> = 0>
+    MaybeError(unexpect_t, Args&&... args)
+    : Storage(detail::error_tag{}, [&] { return E(std::forward<Args>(args)...); })
+    {
     }
 
     /**
@@ -67,7 +83,7 @@ public:
      */
     bool ok()
     {
-        return ok_;
+        return detail::is_ok(this->state());
     }
 
     /**
@@ -81,17 +97,17 @@ public:
      * Throws MovedOutException if this MaybeError has already been
      * consumed.
      */
-    E&& unpack_error()
+    error_type unpack_error()
     {
-        check_is_moved();
-
-        if (ok_)
+        if constexpr (Policy::checked)
         {
-            throw UnpackErrorIfOkException();
+            if (BOWL_UNLIKELY(this->state() != detail::State::error))
+            {
+                unpack_error_failed();
+            }
         }
-        is_moved_ = true;
 
-        return std::move(e_);
+        return this->take_error();
     }
 
     /**
@@ -106,38 +122,234 @@ public:
      */
     void throw_if_error()
     {
-        if (!ok_)
+        if (BOWL_UNLIKELY(!ok()))
+        {
+            throw_error();
+        }
+    }
+
+    /**
+     *
+     * Destroys the current contents and constructs a new error object in place from `args`.
+     * Afterwards, this MaybeError is !ok() and can be unpacked again.
+     *
+     * If constructing E from `args` can throw, E is constructed first and then moved in,
+     * so this MaybeError is never left without contents.
+     */
+    template <class... Args>
+    E& emplace_error(Args&&... args)
+    {
+        if constexpr (std::is_nothrow_constructible_v<E, Args...>)
+        {
+            this->emplace(detail::error_tag{}, [&] { return E(std::forward<Args>(args)...); });
+        }
+        else
+        {
+            static_assert(std::is_nothrow_move_constructible_v<E>,
+                          "emplace_error() needs either a noexcept constructor or move constructor");
+
+            E tmp(std::forward<Args>(args)...);
+            this->emplace(detail::error_tag{}, [&] { return std::move(tmp); });
+        }
+        return this->e_;
+    }
+
+    /**
+     *
+     * Combinators
+     *
+     * All combinators consume this MaybeError, just like unpack_error(), and build their
+     * result directly in the storage of the returned object.
+     */
+
+    /**
+     *
+     * If ok(), returns Expected<U, E>, containing f() with U being the return type of f.
+     * Otherwise passes the error on.
+     */
+    template <class F>
+    auto map(F&& f) &&
+    {
+        using U = detail::map_result_t<std::invoke_result_t<F>>;
+        using R = Expected<U, E, Policy>;
+
+        check_is_moved();
+
+        if (BOWL_LIKELY(ok()))
         {
-            check_is_moved();
-            is_moved_ = true;
-            e_.throw_as_exception();
+            return R(detail::ok_tag{},
+                     [&]() -> decltype(auto) { return detail::invoke(std::forward<F>(f)); });
         }
+        return R(detail::error_tag{}, [&] { return this->take_error(); });
+    }
+
+    template <class F>
+    auto map(F&& f) &
+    {
+        return std::move(*this).map(std::forward<F>(f));
     }
 
-    ~MaybeError()
+    /**
+     *
+     * If ok(), returns f(), which has to return a MaybeError<E> or an Expected<U, E>.
+     * Otherwise passes the error on.
+     */
+    template <class F>
+    auto and_then(F&& f) &&
     {
-        if (!ok_)
+        using R = std::invoke_result_t<F>;
+
+        check_is_moved();
+
+        if (BOWL_LIKELY(ok()))
         {
-            e_.~E();
+            return detail::invoke(std::forward<F>(f));
         }
+        return R(detail::error_tag{}, [&] { return this->take_error(); });
+    }
+
+    template <class F>
+    auto and_then(F&& f) &
+    {
+        return std::move(*this).and_then(std::forward<F>(f));
+    }
+
+    /**
+     *
+     * If !ok(), returns f(E), which has to return a MaybeError<E2>.
+     * Otherwise returns an ok() MaybeError<E2>.
+     */
+    template <class F>
+    auto or_else(F&& f) &&
+    {
+        using R = std::invoke_result_t<F, error_type>;
+
+        check_is_moved();
+
+        if (BOWL_LIKELY(ok()))
+        {
+            return R();
+        }
+        return detail::invoke(std::forward<F>(f), this->take_error());
+    }
+
+    template <class F>
+    auto or_else(F&& f) &
+    {
+        return std::move(*this).or_else(std::forward<F>(f));
+    }
+
+    /**
+     *
+     * If !ok(), returns MaybeError<E2>, containing f(E) with E2 being the return type of f.
+     * Otherwise returns an ok() MaybeError<E2>.
+     */
+    template <class F>
+    auto map_error(F&& f) &&
+    {
+        using E2 = std::remove_cv_t<std::remove_reference_t<std::invoke_result_t<F, error_type>>>;
+        using R = MaybeError<E2, Policy>;
+
+        check_is_moved();
+
+        if (BOWL_LIKELY(ok()))
+        {
+            return R();
+        }
+        return R(detail::error_tag{},
+                 [&] { return detail::invoke(std::forward<F>(f), this->take_error()); });
+    }
+
+    template <class F>
+    auto map_error(F&& f) &
+    {
+        return std::move(*this).map_error(std::forward<F>(f));
+    }
+
+    /**
+     *
+     * If !ok(), returns MaybeError<Contextual<E>> with a context frame formatted from `fmt` and
+     * `args` added to the error, see bowl/context.hpp, which has to be included to use this.
+     * Otherwise returns an ok() MaybeError<Contextual<E>>.
+     */
+    template <class... Args>
+    auto with_context(const char* fmt, const Args&... args) &&;
+
+    template <class... Args>
+    auto with_context(const char* fmt, const Args&... args) &
+    {
+        return std::move(*this).with_context(fmt, args...);
     }
 
 private:
+    template <class, class, class>
+    friend class Expected;
+
+    template <class, class>
+    friend class MaybeError;
+
+    /**
+     * Constructs E directly in the storage from the return value of `make()`.
+     */
+    template <class Make>
+    MaybeError(detail::error_tag tag, Make&& make) : Storage(tag, std::forward<Make>(make))
+    {
+    }
+
+    /**
+     * Constructs an ok() MaybeError after calling `make()`, so that Expected<void, E>
+     * can pass its success on into a MaybeError<E>.
+     */
+    template <class Make>
+    MaybeError(detail::ok_tag, Make&& make) : Storage()
+    {
+        make();
+    }
+
     void check_is_moved()
     {
-        if (is_moved_)
+        if constexpr (Policy::checked)
         {
-            throw MovedOutException();
+            if (BOWL_UNLIKELY(detail::is_moved(this->state())))
+            {
+                Policy::moved_out();
+            }
         }
     }
 
-    bool ok_;
-    bool is_moved_;
+    /**
+     * The error paths, kept out of line so that building the exceptions is not inlined into
+     * every caller.
+     */
+    [[noreturn]] BOWL_COLD void unpack_error_failed()
+    {
+        check_is_moved();
+        Policy::unpack_error_if_ok();
+    }
 
-    union
+    BOWL_COLD void throw_error()
     {
-        E e_;
-        char placeholder_;
-    };
+        check_is_moved();
+
+        auto&& e = this->take_error();
+        error_traits<E>::throw_as_exception(e);
+    }
 };
+
+namespace detail
+{
+
+template <class E, class Policy>
+bool must_propagate(MaybeError<E, Policy>& me)
+{
+    return !me.ok();
+}
+
+template <class E, class Policy>
+Unit unpack_assign(MaybeError<E, Policy>&)
+{
+    return {};
+}
+
+} // namespace detail
 } // namespace bowl
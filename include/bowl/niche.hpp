@@ -0,0 +1,253 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace bowl
+{
+
+/**
+ *
+ * niche_traits<X>: opt-in description of bit patterns ("niches") that no valid X ever has.
+ *
+ * If the payload of an Expected, MaybeError or Unexpected has enough niches, the
+ * ok/error/moved out state is stored inside of them, instead of in an extra state byte
+ * next to the payload.
+ *
+ * A specialization has to provide:
+ *
+ * - `static constexpr std::size_t count`: the number of spare bit patterns.
+ * - `static constexpr std::size_t offset`: the first byte of X that store() and load() touch.
+ * - `static void store(void* x, std::size_t n)`: write spare pattern n < count into the storage
+ *   of an X.
+ * - `static std::size_t load(const void* x)`: return n if the storage of an X contains spare
+ *   pattern n, or count if it contains a valid X.
+ *
+ * X has to be trivially copyable and trivially destructible, because the storage of a consumed
+ * X is overwritten with a spare pattern without calling its destructor.
+ */
+template <class X>
+struct niche_traits
+{
+    static constexpr std::size_t count = 0;
+    static constexpr std::size_t offset = 0;
+};
+
+/**
+ *
+ * Pointers: addresses in the first page of memory are never valid on Linux,
+ * so they are used as spare patterns. nullptr stays a valid value.
+ */
+template <class X>
+struct niche_traits<X*>
+{
+    static constexpr std::size_t count = 4095;
+    static constexpr std::size_t offset = 0;
+
+    static void store(void* x, std::size_t n)
+    {
+        std::uintptr_t val = n + 1;
+        std::memcpy(x, &val, sizeof(val));
+    }
+
+    static std::size_t load(const void* x)
+    {
+        std::uintptr_t val;
+        std::memcpy(&val, x, sizeof(val));
+
+        // 0 (nullptr) wraps around and is reported as a valid pointer
+        return val - 1 < count ? val - 1 : count;
+    }
+};
+
+/**
+ *
+ * Helper for types with a spare byte at `Offset`, which is always 0 in valid objects.
+ *
+ * struct Sample
+ * {
+ *     int64_t value;
+ *     int32_t count;
+ *     uint8_t reserved = 0;
+ * };
+ *
+ * template <>
+ * struct bowl::niche_traits<Sample> : bowl::byte_niche<Sample, offsetof(Sample, reserved)>
+ * {
+ * };
+ */
+template <class X, std::size_t Offset>
+struct byte_niche
+{
+    static_assert(Offset < sizeof(X), "spare byte must lie within the object");
+
+    static constexpr std::size_t count = 255;
+    static constexpr std::size_t offset = Offset;
+
+    static void store(void* x, std::size_t n)
+    {
+        static_cast<unsigned char*>(x)[Offset] = static_cast<unsigned char>(n + 1);
+    }
+
+    static std::size_t load(const void* x)
+    {
+        unsigned char val = static_cast<const unsigned char*>(x)[Offset];
+        return val == 0 ? count : val - 1;
+    }
+};
+
+/**
+ *
+ * errno_word_traits<E>: opt-in for error types which are nothing but an errno.
+ *
+ * An Expected<std::size_t, E> then keeps its whole state in a single ssize_t, following the
+ * convention of Linux syscalls: values >= 0 are the success object, -4095..-1 the negated errno
+ * of the error. Success objects have to be in 0..SSIZE_MAX, which are all values a syscall can
+ * return. Checked policies abort on larger ones. Signed success types are not packed, as their
+ * negative values are valid success objects.
+ *
+ * A specialization has to provide:
+ *
+ * - `static int to_errno(const E& err)`: the errno of `err`, in 1..4095
+ * - `static E from_errno(int errnum)`: the error for an errno returned by to_errno()
+ */
+template <class E>
+struct errno_word_traits
+{
+};
+
+namespace detail
+{
+
+template <class E, class = void>
+struct has_errno_word : std::false_type
+{
+};
+
+template <class E>
+struct has_errno_word<
+    E, std::void_t<decltype(errno_word_traits<E>::to_errno(std::declval<const E&>()))>>
+: std::true_type
+{
+};
+
+/**
+ * True if an Expected<T, E> is packed into one signed word.
+ */
+template <class T, class E>
+constexpr bool is_errno_word_v = has_errno_word<E>::value && std::is_same_v<T, std::size_t>;
+
+/**
+ * The state of an Expected, MaybeError or Unexpected, packed into one byte.
+ */
+enum class State : std::uint8_t
+{
+    ok = 0,
+    error = 1,
+    ok_moved = 2,
+    error_moved = 3,
+};
+
+/**
+ * Constructor tags for the storage of the containers. The constructors take a callable `make`
+ * and initialize the payload from `make()`, so that a payload returned by value from `make` is
+ * constructed directly in the storage, without any intermediate moves.
+ */
+struct ok_tag
+{
+};
+
+struct error_tag
+{
+};
+
+constexpr bool is_ok(State s)
+{
+    return s == State::ok || s == State::ok_moved;
+}
+
+constexpr bool is_moved(State s)
+{
+    return s == State::ok_moved || s == State::error_moved;
+}
+
+constexpr State moved(State s)
+{
+    return is_ok(s) ? State::ok_moved : State::error_moved;
+}
+
+/**
+ * How a container lays out its payload and its State.
+ *
+ * - generic: separate State byte, hand written special members
+ * - trivial: separate State byte, defaulted special members
+ * - niche_ok: State stored in the niches of the ok type
+ * - niche_error: State stored in the niches of the error type
+ * - errno_word: success object and error packed into one signed word, see errno_word_traits
+ * - bare: no State at all, the container always holds its payload
+ */
+enum class Layout
+{
+    generic,
+    trivial,
+    niche_ok,
+    niche_error,
+    errno_word,
+    bare,
+};
+
+/**
+ * Number of spare patterns needed to encode all States but the live one: ok and error if
+ * moves are not tracked, ok, error, ok_moved and error_moved otherwise.
+ */
+constexpr std::size_t niche_spares(bool track_moves)
+{
+    return track_moves ? 3 : 1;
+}
+
+/**
+ * True if the state of a container can live in the niches of X, while the other alternative
+ * of the container occupies the first `other_size` bytes of the same storage.
+ */
+template <class X>
+constexpr bool has_niche_v(std::size_t other_size, std::size_t spares)
+{
+    return std::is_trivially_copyable_v<X> && std::is_trivially_destructible_v<X> &&
+           niche_traits<X>::count >= spares && niche_traits<X>::offset >= other_size;
+}
+
+/**
+ * Stores a State in the niches of X. `Live` is the state in which the storage contains a valid X,
+ * all other states are mapped onto the spare patterns of X.
+ */
+template <class X, State Live>
+struct NicheState
+{
+    static State load(const void* x)
+    {
+        std::size_t n = niche_traits<X>::load(x);
+
+        if (n == niche_traits<X>::count)
+        {
+            return Live;
+        }
+        return static_cast<State>(n >= static_cast<std::size_t>(Live) ? n + 1 : n);
+    }
+
+    static void store(void* x, State s)
+    {
+        if (s != Live)
+        {
+            std::size_t n = static_cast<std::size_t>(s);
+            niche_traits<X>::store(x, s > Live ? n - 1 : n);
+        }
+    }
+};
+
+} // namespace detail
+} // namespace bowl
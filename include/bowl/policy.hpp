@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <bowl/config.hpp>
+#include <bowl/exception.hpp>
+#include <bowl/fwd.hpp>
+
+namespace bowl
+{
+namespace policy
+{
+
+#ifndef BOWL_NO_EXCEPTIONS
+/**
+ *
+ * Checks every access and throws MovedOutException, UnpackErrorIfOkException or
+ * UnpackOkIfErrorException<E> on misuse.
+ *
+ * This is the default policy, unless BOWL_NO_EXCEPTIONS is defined.
+ */
+struct Throw
+{
+    static constexpr bool checked = true;
+
+    [[noreturn]] BOWL_COLD static void moved_out()
+    {
+        throw MovedOutException();
+    }
+
+    [[noreturn]] BOWL_COLD static void unpack_error_if_ok()
+    {
+        throw UnpackErrorIfOkException();
+    }
+
+    template <class E>
+    [[noreturn]] BOWL_COLD static void unpack_ok_if_error(const E& err)
+    {
+        throw UnpackOkIfErrorException<E>(err);
+    }
+};
+#endif
+
+/**
+ *
+ * Checks every access and prints a message and aborts on misuse.
+ *
+ * This is the default policy if BOWL_NO_EXCEPTIONS is defined.
+ */
+struct Abort
+{
+    static constexpr bool checked = true;
+
+    [[noreturn]] BOWL_COLD static void moved_out()
+    {
+        detail::abort_with(MovedOutException().what());
+    }
+
+    [[noreturn]] BOWL_COLD static void unpack_error_if_ok()
+    {
+        detail::abort_with(UnpackErrorIfOkException().what());
+    }
+
+    template <class E>
+    [[noreturn]] BOWL_COLD static void unpack_ok_if_error(const E& err)
+    {
+        detail::abort_with(UnpackOkIfErrorException<E>(err).what());
+    }
+};
+
+/**
+ *
+ * Does not check any access. Unpacking an object twice or unpacking the wrong case
+ * is undefined behaviour.
+ *
+ * Objects using this policy do not track whether they have been moved out of, which
+ * saves the branch on every access and, where possible, the state byte.
+ */
+struct Unchecked
+{
+    static constexpr bool checked = false;
+};
+
+} // namespace policy
+} // namespace bowl
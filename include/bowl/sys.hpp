@@ -0,0 +1,187 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <bowl/error.hpp>
+#include <bowl/expected.hpp>
+#include <bowl/maybe_error.hpp>
+
+#include <cerrno>
+#include <cstddef>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace bowl
+{
+
+/**
+ *
+ * Thin wrappers around libc syscalls, which report failures as ErrnoError instead of -1 and
+ * errno.
+ *
+ * Calls which can be interrupted by a signal are restarted on EINTR. Byte counts are returned as
+ * Expected<std::size_t, ErrnoError>, which is packed into a single ssize_t, so the wrappers
+ * return exactly what the raw calls return.
+ */
+namespace sys
+{
+
+using ssize = std::make_signed_t<std::size_t>;
+
+namespace detail
+{
+
+/**
+ * Calls `call` until it does not fail with EINTR.
+ */
+template <class Call>
+auto retry(Call&& call)
+{
+    auto ret = call();
+
+    while (ret == -1 && errno == EINTR)
+    {
+        ret = call();
+    }
+    return ret;
+}
+
+inline Expected<std::size_t, ErrnoError> to_size(ssize ret)
+{
+    if (ret < 0)
+    {
+        return { unexpect };
+    }
+    return { std::in_place, static_cast<std::size_t>(ret) };
+}
+
+inline Expected<int, ErrnoError> to_fd(int ret)
+{
+    if (ret < 0)
+    {
+        return { unexpect };
+    }
+    return { std::in_place, ret };
+}
+
+} // namespace detail
+
+/**
+ *
+ * Converts the return value of a raw syscall or io_uring completion, which is the negated errno
+ * on failure, into an Expected.
+ */
+inline Expected<std::size_t, ErrnoError> from_raw(ssize ret)
+{
+    if (ret < 0)
+    {
+        return { unexpect, ErrnoError::from_raw(static_cast<int>(ret)) };
+    }
+    return { std::in_place, static_cast<std::size_t>(ret) };
+}
+
+inline Expected<int, ErrnoError> open(const char* path, int flags, mode_t mode = 0)
+{
+    return detail::to_fd(detail::retry([&] { return ::open(path, flags, mode); }));
+}
+
+inline Expected<std::size_t, ErrnoError> read(int fd, void* buf, std::size_t count)
+{
+    return detail::to_size(detail::retry([&] { return ::read(fd, buf, count); }));
+}
+
+inline Expected<std::size_t, ErrnoError> write(int fd, const void* buf, std::size_t count)
+{
+    return detail::to_size(detail::retry([&] { return ::write(fd, buf, count); }));
+}
+
+inline Expected<std::size_t, ErrnoError> pread(int fd, void* buf, std::size_t count, off_t offset)
+{
+    return detail::to_size(detail::retry([&] { return ::pread(fd, buf, count, offset); }));
+}
+
+inline Expected<std::size_t, ErrnoError> pwrite(int fd, const void* buf, std::size_t count,
+                                                off_t offset)
+{
+    return detail::to_size(detail::retry([&] { return ::pwrite(fd, buf, count, offset); }));
+}
+
+inline Expected<std::size_t, ErrnoError> readv(int fd, const iovec* iov, int iovcnt)
+{
+    return detail::to_size(detail::retry([&] { return ::readv(fd, iov, iovcnt); }));
+}
+
+inline Expected<std::size_t, ErrnoError> writev(int fd, const iovec* iov, int iovcnt)
+{
+    return detail::to_size(detail::retry([&] { return ::writev(fd, iov, iovcnt); }));
+}
+
+/**
+ *
+ * close() is not restarted: on Linux, the file descriptor is released even if close() fails
+ * with EINTR, and closing it again could close a descriptor opened by another thread in the
+ * meantime. EINTR is therefore reported as success.
+ */
+inline MaybeError<ErrnoError> close(int fd)
+{
+    if (::close(fd) < 0 && errno != EINTR)
+    {
+        return { unexpect };
+    }
+    return {};
+}
+
+inline Expected<struct stat, ErrnoError> fstat(int fd)
+{
+    struct stat st;
+
+    if (::fstat(fd, &st) < 0)
+    {
+        return { unexpect };
+    }
+    return { std::in_place, st };
+}
+
+inline Expected<void*, ErrnoError> mmap(void* addr, std::size_t length, int prot, int flags, int fd,
+                                        off_t offset)
+{
+    void* ptr = ::mmap(addr, length, prot, flags, fd, offset);
+
+    if (ptr == MAP_FAILED)
+    {
+        return { unexpect };
+    }
+    return { std::in_place, ptr };
+}
+
+inline MaybeError<ErrnoError> munmap(void* addr, std::size_t length)
+{
+    if (::munmap(addr, length) < 0)
+    {
+        return { unexpect };
+    }
+    return {};
+}
+
+inline MaybeError<ErrnoError> madvise(void* addr, std::size_t length, int advice)
+{
+    if (::madvise(addr, length, advice) < 0)
+    {
+        return { unexpect };
+    }
+    return {};
+}
+
+inline Expected<int, ErrnoError> eventfd(unsigned int initval, int flags)
+{
+    return detail::to_fd(::eventfd(initval, flags));
+}
+
+} // namespace sys
+} // namespace bowl
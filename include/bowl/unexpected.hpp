@@ -3,7 +3,12 @@
 #pragma once
 
 #include <bowl/exception.hpp>
+#include <bowl/fwd.hpp>
+#include <bowl/niche.hpp>
+#include <bowl/policy.hpp>
 
+#include <new>
+#include <type_traits>
 #include <utility>
 
 namespace bowl
@@ -11,71 +16,348 @@ namespace bowl
 
 /**
  *
- * Unexpected<E>: A convenience class for construction Error states.
+ * Tag type for constructing the error of an Expected<T, E> or MaybeError<E> in place.
+ */
+struct unexpect_t
+{
+    explicit unexpect_t() = default;
+};
+
+inline constexpr unexpect_t unexpect{};
+
+namespace detail
+{
+
+/**
+ * Layout of an optional error E, as used by MaybeError<E, Policy>.
+ */
+template <class E, class Policy>
+constexpr Layout maybe_error_layout_v =
+    has_niche_v<E>(0, niche_spares(Policy::checked)) ? Layout::niche_error
+    : std::is_trivially_copyable_v<E> && std::is_trivially_destructible_v<E> ? Layout::trivial
+                                                                              : Layout::generic;
+
+/**
+ * Layout of an error E that is always there, as used by Unexpected<E, Policy>. Without checks,
+ * there is no State to keep at all.
+ */
+template <class E, class Policy>
+constexpr Layout unexpected_layout_v =
+    Policy::checked ? maybe_error_layout_v<E, Policy> : Layout::bare;
+
+struct NoMoveAssignment
+{
+    NoMoveAssignment() = delete;
+};
+
+/**
+ * Parameter type of the move assignment of a storage, which only exists if `Enable`. Otherwise
+ * the operator takes a type nothing converts to, so the storage and the Expected, MaybeError or
+ * Unexpected around it are not move assignable, instead of failing to compile on use.
+ */
+template <bool Enable, class Storage>
+using move_assignment_arg_t = std::conditional_t<Enable, Storage&&, const NoMoveAssignment&>;
+
+/**
  *
- * A !ok() MaybeError<E>  or !ok() Expected can be constructed from
- * the Unexpected<E>.
+ * Storage of an optional error E and its State, shared by Unexpected<E> and MaybeError<E>.
+ *
+ * If `Track` is false, consuming the error does not change the State.
+ *
+ * This is the generic version, which keeps the State in a separate byte next to the E
+ * and manually dispatches moves and destruction.
  */
-template <class E>
-class Unexpected
+template <class E, bool Track, Layout = Layout::generic>
+class ErrorStorage
 {
-public:
-    Unexpected(E&& e) : e_(std::move(e)), is_moved_(false)
+protected:
+    using error_type = E&&;
+
+    ErrorStorage() : state_(State::ok)
     {
     }
 
-    Unexpected() = delete;
+    template <class Make>
+    ErrorStorage(error_tag, Make&& make) : e_(make()), state_(State::error)
+    {
+    }
 
-    Unexpected(Unexpected<E>& other) = delete;
-    Unexpected<E>& operator=(Unexpected<E>&) = delete;
+    ErrorStorage(ErrorStorage&) = delete;
+    ErrorStorage& operator=(ErrorStorage&) = delete;
 
-    Unexpected<E>& operator=(Unexpected<E>&& other)
+    /**
+     * Moves construct the error of `other` in place, the error of `other` is left in its
+     * moved-from state and destroyed together with `other`.
+     */
+    ErrorStorage(ErrorStorage&& other) noexcept(std::is_nothrow_move_constructible_v<E>)
+    : state_(other.state_)
     {
-        this->e_ = std::move(other.e_);
-        this->is_moved_ = other.is_moved_;
+        construct_from(other);
 
-        other.is_moved_ = true;
+        if constexpr (Track)
+        {
+            other.state_ = moved(other.state_);
+        }
+    }
+
+    /**
+     * Destroys the current error and move constructs the error of `other` in its place, so
+     * E does not need to be assignable. As a throwing move constructor would leave the storage
+     * without an error, this only exists if the one of E is noexcept.
+     */
+    ErrorStorage& operator=(
+        move_assignment_arg_t<std::is_nothrow_move_constructible_v<E>, ErrorStorage> other) noexcept
+    {
+        if (this != &other)
+        {
+            destroy();
+            state_ = other.state_;
+            construct_from(other);
 
+            if constexpr (Track)
+            {
+                other.state_ = moved(other.state_);
+            }
+        }
         return *this;
     }
 
-    Unexpected(Unexpected<E>&& other)
+    ~ErrorStorage()
+    {
+        destroy();
+    }
+
+    void destroy()
     {
-        this->e_ = std::move(other.e_);
-        this->is_moved_ = other.is_moved_;
+        if (!is_ok(state_))
+        {
+            e_.~E();
+        }
+    }
+
+    template <class Make>
+    void emplace(error_tag, Make&& make)
+    {
+        destroy();
+        ::new (static_cast<void*>(&e_)) E(make());
+        state_ = State::error;
+    }
+
+    State state() const
+    {
+        return state_;
+    }
 
-        other.is_moved_ = true;
+    E&& take_error()
+    {
+        if constexpr (Track)
+        {
+            state_ = State::error_moved;
+        }
+        return std::move(e_);
     }
 
     /**
-     *
-     * Unpacks the Unexpected, consuming it.
-     *
-     * Throws MovedOutException, if this Unexpected has already been consumed.
+     * Move constructs the error of `other`, if there is one, according to the already copied State.
      */
-    E&& unpack()
+    void construct_from(ErrorStorage& other)
     {
-        if (is_moved_ == true)
+        if (!is_ok(state_))
         {
-            throw MovedOutException();
+            ::new (static_cast<void*>(&e_)) E(std::move(other.e_));
         }
+    }
+
+    union
+    {
+        E e_;
+        char placeholder_;
+    };
+
+    State state_;
+};
+
+/**
+ *
+ * Storage for trivially copyable and destructible E, with defaulted special members.
+ */
+template <class E, bool Track>
+class ErrorStorage<E, Track, Layout::trivial>
+{
+protected:
+    using error_type = E&&;
+
+    ErrorStorage() : state_(State::ok)
+    {
+    }
+
+    template <class Make>
+    ErrorStorage(error_tag, Make&& make) : e_(make()), state_(State::error)
+    {
+    }
+
+    template <class Make>
+    void emplace(error_tag, Make&& make)
+    {
+        ::new (static_cast<void*>(&e_)) E(make());
+        state_ = State::error;
+    }
+
+    State state() const
+    {
+        return state_;
+    }
 
-        is_moved_ = true;
+    E&& take_error()
+    {
+        if constexpr (Track)
+        {
+            state_ = State::error_moved;
+        }
         return std::move(e_);
     }
 
-    ~Unexpected()
+    union
+    {
+        E e_;
+        char placeholder_;
+    };
+
+    State state_;
+};
+
+/**
+ *
+ * Storage for E with niches, the State is kept inside of the storage of E.
+ *
+ * As the storage of E is overwritten when it is consumed, the error is returned by value.
+ */
+template <class E, bool Track>
+class ErrorStorage<E, Track, Layout::niche_error>
+{
+    using Niche = NicheState<E, State::error>;
+
+protected:
+    using error_type = E;
+
+    ErrorStorage()
+    {
+        Niche::store(&e_, State::ok);
+    }
+
+    template <class Make>
+    ErrorStorage(error_tag, Make&& make) : e_(make())
     {
-        e_.~E();
     }
 
-private:
+    template <class Make>
+    void emplace(error_tag, Make&& make)
+    {
+        ::new (static_cast<void*>(&e_)) E(make());
+    }
+
+    State state() const
+    {
+        return Niche::load(&e_);
+    }
+
+    E take_error()
+    {
+        E e = e_;
+
+        if constexpr (Track)
+        {
+            Niche::store(&e_, State::error_moved);
+        }
+        return e;
+    }
+
     union
     {
         E e_;
-        char placeholder;
+        char placeholder_;
     };
+};
+
+/**
+ *
+ * Storage for an E that is always there and whose consumption is not tracked.
+ */
+template <class E, bool Track>
+class ErrorStorage<E, Track, Layout::bare>
+{
+    static_assert(!Track, "bare storage can not track moves");
+
+protected:
+    using error_type = E&&;
+
+    template <class Make>
+    ErrorStorage(error_tag, Make&& make) : e_(make())
+    {
+    }
 
-    bool is_moved_;
+    State state() const
+    {
+        return State::error;
+    }
+
+    E&& take_error()
+    {
+        return std::move(e_);
+    }
+
+    E e_;
+};
+
+} // namespace detail
+
+/**
+ *
+ * Unexpected<E>: A convenience class for construction Error states.
+ *
+ * A !ok() MaybeError<E>  or !ok() Expected can be constructed from
+ * the Unexpected<E>.
+ */
+template <class E, class Policy>
+class Unexpected
+: private detail::ErrorStorage<E, Policy::checked, detail::unexpected_layout_v<E, Policy>>
+{
+    using Storage = detail::ErrorStorage<E, Policy::checked, detail::unexpected_layout_v<E, Policy>>;
+
+public:
+    Unexpected(E&& e) : Storage(detail::error_tag{}, [&] { return std::move(e); })
+    {
+    }
+
+    /**
+     *
+     * Construct the contained E in place from `args`.
+     */
+    template <class... Args, std::enable_if_t<std::is_constructible_v<E, Args...>, int> = 0>
+    Unexpected(std::in_place_t, Args&&... args)
+    : Storage(detail::error_tag{}, [&] { return E(std::forward<Args>(args)...); })
+    {
+    }
+
+    Unexpected() = delete;
+
+    /**
+     *
+     * Unpacks the Unexpected, consuming it.
+     *
+     * Throws MovedOutException, if this Unexpected has already been consumed.
+     */
+    typename Storage::error_type unpack()
+    {
+        if constexpr (Policy::checked)
+        {
+            if (BOWL_UNLIKELY(detail::is_moved(this->state())))
+            {
+                Policy::moved_out();
+            }
+        }
+
+        return this->take_error();
+    }
 };
 } // namespace bowl
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: MIT
+
+// The C++20 module `bowl`, built if BOWL_BUILD_MODULE is ON. It exports the same entities as
+// the headers. Macros can not be exported from modules, so for CHECK_ASSIGN and BOWL_TRY
+// include <bowl/macros.hpp> next to `import bowl;`, and <bowl/catalog.hpp> for
+// BOWL_CATALOG_ERROR.
+
+module;
+
+#include <bowl/any_error.hpp>
+#include <bowl/catalog.hpp>
+#include <bowl/context.hpp>
+#include <bowl/errno.hpp>
+#include <bowl/error.hpp>
+#include <bowl/error_set.hpp>
+#include <bowl/error_traits.hpp>
+#include <bowl/exception.hpp>
+#include <bowl/expected.hpp>
+#include <bowl/mapped_file.hpp>
+#include <bowl/maybe_error.hpp>
+#include <bowl/niche.hpp>
+#include <bowl/policy.hpp>
+#include <bowl/sys.hpp>
+#include <bowl/unexpected.hpp>
+
+export module bowl;
+
+export namespace bowl
+{
+
+using bowl::DefaultPolicy;
+using bowl::Expected;
+using bowl::MaybeError;
+using bowl::Ref;
+using bowl::Unexpected;
+using bowl::unexpect;
+using bowl::unexpect_t;
+
+using bowl::MovedOutException;
+using bowl::UnpackErrorIfOkException;
+using bowl::UnpackOkIfErrorException;
+
+using bowl::error_conversion;
+using bowl::error_traits;
+using bowl::is_error_v;
+
+using bowl::byte_niche;
+using bowl::errno_word_traits;
+using bowl::niche_traits;
+
+using bowl::AnyError;
+using bowl::catalog;
+using bowl::catalog_find;
+using bowl::CatalogEntry;
+using bowl::CatalogError;
+using bowl::CatalogException;
+using bowl::Contextual;
+using bowl::CustomError;
+using bowl::CustomException;
+using bowl::dump_catalog;
+using bowl::Errno;
+using bowl::errno_display_to;
+using bowl::errno_info;
+using bowl::ErrnoError;
+using bowl::ErrnoException;
+using bowl::ErrnoInfo;
+using bowl::Error;
+using bowl::ErrorAdapter;
+using bowl::ErrorSet;
+using bowl::FormattedError;
+using bowl::FormattedException;
+
+using bowl::MappedFile;
+
+namespace policy
+{
+using bowl::policy::Abort;
+#ifndef BOWL_NO_EXCEPTIONS
+using bowl::policy::Throw;
+#endif
+using bowl::policy::Unchecked;
+} // namespace policy
+
+namespace sys
+{
+using bowl::sys::close;
+using bowl::sys::eventfd;
+using bowl::sys::from_raw;
+using bowl::sys::fstat;
+using bowl::sys::madvise;
+using bowl::sys::mmap;
+using bowl::sys::munmap;
+using bowl::sys::open;
+using bowl::sys::pread;
+using bowl::sys::pwrite;
+using bowl::sys::read;
+using bowl::sys::readv;
+using bowl::sys::ssize;
+using bowl::sys::write;
+using bowl::sys::writev;
+} // namespace sys
+
+// Used by the expansions of CHECK_ASSIGN and BOWL_TRY
+namespace detail
+{
+using bowl::detail::CatalogRegistrar;
+using bowl::detail::must_propagate;
+using bowl::detail::PropagateError;
+using bowl::detail::try_unsupported;
+using bowl::detail::try_value;
+using bowl::detail::unpack_assign;
+} // namespace detail
+
+} // namespace bowl
@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: MIT
+
+// Checks that AnyError tells the types of errors created in a plugin built with hidden
+// visibility, see any_error_plugin.cpp.
+
+#include <bowl/any_error.hpp>
+#include <bowl/error.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+
+#define EXPECT(cond)                                                                               \
+    if (!(cond))                                                                                   \
+    {                                                                                              \
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);              \
+        return EXIT_FAILURE;                                                                       \
+    }
+
+bowl::AnyError plugin_error();
+bool plugin_holds_errno(const bowl::AnyError& err);
+
+int main()
+{
+    bowl::AnyError err = plugin_error();
+
+    EXPECT(err.is<bowl::ErrnoError>());
+    EXPECT(!err.is<bowl::CustomError>());
+    EXPECT(err.as<bowl::ErrnoError>()->errnum() == bowl::Errno::NOENT);
+    EXPECT(err.display() == "No such file or directory");
+
+    EXPECT(plugin_holds_errno(bowl::ErrnoError(bowl::Errno::PIPE)));
+    EXPECT(!plugin_holds_errno(bowl::CustomError::literal("not an errno")));
+
+    std::puts("ok");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,19 @@
+// SPDX-License-Identifier: MIT
+
+// A plugin built with hidden visibility, so it has its own copies of bowl's inline variables,
+// including the tables AnyError identifies types with.
+
+#include <bowl/any_error.hpp>
+#include <bowl/error.hpp>
+
+#define PLUGIN_EXPORT __attribute__((visibility("default")))
+
+PLUGIN_EXPORT bowl::AnyError plugin_error()
+{
+    return bowl::ErrnoError(bowl::Errno::NOENT);
+}
+
+PLUGIN_EXPORT bool plugin_holds_errno(const bowl::AnyError& err)
+{
+    return err.is<bowl::ErrnoError>();
+}
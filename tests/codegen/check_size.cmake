@@ -0,0 +1,32 @@
+# SPDX-License-Identifier: MIT
+#
+# Compares the hot .text of reference_bowl() with that of reference_plain(). Both objects are
+# compiled with -ffunction-sections, so every function has its own section, and the cold
+# error paths end up in separate .text.unlikely sections which are not counted.
+#
+# Usage: cmake -DOBJDUMP=... -DPLAIN_OBJ=... -DBOWL_OBJ=... -DMAX_RATIO_PERCENT=... -P check_size.cmake
+
+function(text_size obj symbol out)
+    execute_process(COMMAND ${OBJDUMP} -h ${obj} OUTPUT_VARIABLE headers RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "objdump -h ${obj} failed")
+    endif()
+
+    string(REGEX MATCH "[ \t]\\.text\\.${symbol}[ \t]+([0-9a-f]+)" match "${headers}")
+    if(NOT match)
+        message(FATAL_ERROR "no section .text.${symbol} in ${obj}")
+    endif()
+
+    math(EXPR size "0x${CMAKE_MATCH_1}")
+    set(${out} ${size} PARENT_SCOPE)
+endfunction()
+
+text_size(${PLAIN_OBJ} _Z15reference_plainiPi plain)
+text_size(${BOWL_OBJ} _Z14reference_bowli bowl)
+
+math(EXPR limit "${plain} * ${MAX_RATIO_PERCENT} / 100")
+message(STATUS "reference_plain: ${plain} bytes, reference_bowl: ${bowl} bytes, limit: ${limit}")
+
+if(bowl GREATER limit)
+    message(FATAL_ERROR "hot .text of reference_bowl() exceeds ${MAX_RATIO_PERCENT}% of reference_plain()")
+endif()
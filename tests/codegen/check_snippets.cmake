@@ -0,0 +1,83 @@
+# SPDX-License-Identifier: MIT
+#
+# Checks the code generated for snippets.cpp on x86-64. Only the hot part of every function is
+# looked at; the parts which GCC moves into .text.unlikely (`<name>.cold`) are error paths.
+#
+# For every snippet, the hot part must not exceed a number of instructions and a number of
+# bytes of stack (pushes and the stack pointer adjustment), and it must not call operator new,
+# malloc or throw an exception.
+#
+# Usage: cmake -DOBJDUMP=... -DOBJ=... -P check_snippets.cmake
+
+# name, max instructions, max stack bytes
+set(snippets
+    codegen_return_ok 5 0
+    codegen_return_error 5 0
+    codegen_maybe_ok 2 0
+    codegen_maybe_error 2 0
+    codegen_propagate 26 40
+    codegen_propagate_word 22 40
+    codegen_try 26 56
+    codegen_unpack 6 0
+    codegen_throw_if_error 12 0
+    codegen_catalog_error 8 0)
+
+set(forbidden "(_Znw|_Zna|malloc|__cxa_allocate_exception|__cxa_throw)")
+
+execute_process(COMMAND ${OBJDUMP} -dr --no-show-raw-insn ${OBJ}
+    OUTPUT_VARIABLE disassembly RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "objdump -dr ${OBJ} failed")
+endif()
+# Keep semicolons in comments from splitting the lists below
+string(REPLACE ";" "," disassembly "${disassembly}")
+
+set(failed FALSE)
+list(LENGTH snippets count)
+math(EXPR last "${count} - 1")
+
+foreach(i RANGE 0 ${last} 3)
+    math(EXPR j "${i} + 1")
+    math(EXPR k "${i} + 2")
+    list(GET snippets ${i} name)
+    list(GET snippets ${j} max_insns)
+    list(GET snippets ${k} max_stack)
+
+    string(FIND "${disassembly}" "<${name}>:\n" begin)
+    if(begin EQUAL -1)
+        message(FATAL_ERROR "${name} not found in ${OBJ}")
+    endif()
+    string(SUBSTRING "${disassembly}" ${begin} -1 body)
+    string(FIND "${body}" "\n\n" end)
+    string(SUBSTRING "${body}" 0 ${end} body)
+
+    string(REGEX MATCHALL "\n +[0-9a-f]+:\t[^\n]*" insns "${body}")
+    list(LENGTH insns num_insns)
+
+    string(REGEX MATCHALL "\tpush " pushes "${body}")
+    list(LENGTH pushes num_pushes)
+    math(EXPR stack "${num_pushes} * 8")
+    if(body MATCHES "\tsub +\\$0x([0-9a-f]+),%rsp")
+        math(EXPR stack "${stack} + 0x${CMAKE_MATCH_1}")
+    endif()
+
+    message(STATUS "${name}: ${num_insns} instructions (max ${max_insns}), "
+                   "${stack} bytes of stack (max ${max_stack})")
+
+    if(num_insns GREATER max_insns)
+        message(SEND_ERROR "${name}: too many instructions")
+        set(failed TRUE)
+    endif()
+    if(stack GREATER max_stack)
+        message(SEND_ERROR "${name}: too much stack")
+        set(failed TRUE)
+    endif()
+    if(body MATCHES "${forbidden}")
+        message(SEND_ERROR "${name}: success path calls ${CMAKE_MATCH_1}")
+        set(failed TRUE)
+    endif()
+endforeach()
+
+if(failed)
+    message(FATAL_ERROR "codegen of ${OBJ} regressed")
+endif()
@@ -0,0 +1,18 @@
+// SPDX-License-Identifier: MIT
+
+// Reference function for the .text size check: the same two fallible steps as in
+// size_plain.cpp, propagated through CHECK_ASSIGN.
+
+#include <bowl/error.hpp>
+#include <bowl/expected.hpp>
+#include <bowl/macros.hpp>
+
+bowl::Expected<int, bowl::ErrnoError> step_bowl(int v);
+
+bowl::Expected<int, bowl::ErrnoError> reference_bowl(int v)
+{
+    CHECK_ASSIGN(a, step_bowl(v));
+    CHECK_ASSIGN(b, step_bowl(a));
+
+    return a + b;
+}
@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: MIT
+
+// Reference function for the .text size check: two fallible steps, propagating failures
+// as negative error codes. See size_bowl.cpp for the same function using bowl.
+
+int step_plain(int v, int* out);
+
+int reference_plain(int v, int* out)
+{
+    int a;
+    int ret = step_plain(v, &a);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    int b;
+    ret = step_plain(a, &b);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    *out = a + b;
+    return 0;
+}
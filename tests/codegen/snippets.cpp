@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: MIT
+
+// Canonical uses of bowl, whose generated code is checked by check_snippets.cmake. The
+// functions have C linkage, so that they can be found by name in the disassembly.
+
+#include <bowl/catalog.hpp>
+#include <bowl/error.hpp>
+#include <bowl/expected.hpp>
+#include <bowl/macros.hpp>
+#include <bowl/maybe_error.hpp>
+
+#include <cstddef>
+
+using bowl::Errno;
+using bowl::ErrnoError;
+using bowl::Expected;
+using bowl::MaybeError;
+using bowl::Unexpected;
+
+Expected<int, ErrnoError> step(int v);
+Expected<std::size_t, ErrnoError> step_word(int v);
+
+BOWL_CATALOG_ERROR(CodegenQueueFull, 0x0101, "queue", "queue {} is full ({} entries)");
+
+extern "C"
+{
+
+Expected<int, ErrnoError> codegen_return_ok(int v)
+{
+    return v;
+}
+
+Expected<int, ErrnoError> codegen_return_error()
+{
+    return Unexpected(ErrnoError(Errno::NOENT));
+}
+
+MaybeError<ErrnoError> codegen_maybe_ok()
+{
+    return {};
+}
+
+MaybeError<ErrnoError> codegen_maybe_error()
+{
+    return Unexpected(ErrnoError(Errno::NOENT));
+}
+
+Expected<int, ErrnoError> codegen_propagate(int v)
+{
+    CHECK_ASSIGN(a, step(v));
+    CHECK_ASSIGN(b, step(a));
+
+    return a + b;
+}
+
+Expected<std::size_t, ErrnoError> codegen_propagate_word(int v)
+{
+    CHECK_ASSIGN(a, step_word(v));
+    CHECK_ASSIGN(b, step_word(v));
+
+    return a + b;
+}
+
+Expected<int, ErrnoError> codegen_try(int v)
+{
+    return BOWL_TRY(step(v)) + BOWL_TRY(step(v + 1));
+}
+
+int codegen_unpack(Expected<int, ErrnoError>& res)
+{
+    return res.unpack_ok();
+}
+
+void codegen_throw_if_error(MaybeError<ErrnoError>& res)
+{
+    res.throw_if_error();
+}
+
+// 16 bytes, returned in rax:rdx
+Expected<int, bowl::CatalogError> codegen_catalog_error(int queue, int size)
+{
+    return Unexpected(bowl::CatalogError(CodegenQueueFull{}, queue, size));
+}
+}
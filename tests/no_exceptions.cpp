@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: MIT
+
+// Built with -fno-exceptions, checks that all headers can be used without exceptions.
+
+#include <bowl/error.hpp>
+#include <bowl/exception.hpp>
+#include <bowl/expected.hpp>
+#include <bowl/macros.hpp>
+#include <bowl/maybe_error.hpp>
+#include <bowl/unexpected.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <type_traits>
+
+#ifndef BOWL_NO_EXCEPTIONS
+#error "BOWL_NO_EXCEPTIONS should be detected under -fno-exceptions"
+#endif
+
+static_assert(std::is_same_v<bowl::DefaultPolicy, bowl::policy::Abort>);
+
+#define EXPECT(cond)                                                                               \
+    if (!(cond))                                                                                   \
+    {                                                                                              \
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);              \
+        return EXIT_FAILURE;                                                                       \
+    }
+
+bowl::Expected<int, bowl::CustomError> returning_error()
+{
+    return bowl::Unexpected(bowl::CustomError("I'm an error!"));
+}
+
+bowl::Expected<int, bowl::CustomError> forwarding_error()
+{
+    CHECK_ASSIGN(foo, returning_error());
+
+    return foo;
+}
+
+bowl::Expected<int, bowl::CustomError, bowl::policy::Unchecked> returning_value()
+{
+    return 42;
+}
+
+int main()
+{
+    auto res = forwarding_error();
+    EXPECT(!res.ok());
+    EXPECT(res.unpack_error().display() == "I'm an error!");
+
+    auto res2 = returning_value();
+    EXPECT(res2.ok());
+    EXPECT(res2.unpack_ok() == 42);
+
+    errno = ENOENT;
+    bowl::MaybeError<bowl::ErrnoError, bowl::policy::Unchecked> err{ bowl::ErrnoError() };
+    EXPECT(!err.ok());
+    EXPECT(err.unpack_error().errnum() == bowl::Errno::NOENT);
+
+    bowl::MaybeError<bowl::ErrnoError> ok_err{};
+    EXPECT(ok_err.ok());
+
+    return EXIT_SUCCESS;
+}
@@ -1,14 +1,32 @@
 // SPDX-License-Identifier: MIT
 
+#include <bowl/any_error.hpp>
+#include <bowl/catalog.hpp>
+#include <bowl/context.hpp>
 #include <bowl/error.hpp>
+#include <bowl/error_set.hpp>
 #include <bowl/exception.hpp>
 #include <bowl/expected.hpp>
 #include <bowl/macros.hpp>
+#include <bowl/mapped_file.hpp>
 #include <bowl/maybe_error.hpp>
+#include <bowl/sys.hpp>
 #include <bowl/unexpected.hpp>
 
 #include <catch2/catch_test_macros.hpp>
 
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <ostream>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
 // Count how often both constructors of ErrorCase and OkCase have been called,
 // so we can check that the move semantics work correctly.
 uint64_t num_constructed = 0;
@@ -326,65 +344,1980 @@ TEST_CASE("Expected::throw_if_error()", "[expected_throw_if_error_works]")
     REQUIRE_THROWS_AS(err_expected.unpack_ok(), bowl::MovedOutException);
 }
 
-TEST_CASE("ErrnoError works", "[errno_error_works]")
+// An error type without virtual functions, so Expected<int, TrivialError> is trivially copyable
+class TrivialError
 {
-    errno = ENOMEM;
-    bowl::ErrnoError errno_error{};
+public:
+    std::string display() const
+    {
+        return "I'm a little trivial error case";
+    }
 
-    REQUIRE(errno_error.errnum() == bowl::Errno::NOMEM);
-    REQUIRE(static_cast<int>(errno_error.errnum()) == ENOMEM);
-    REQUIRE(errno_error.display() == "Cannot allocate memory");
+    [[noreturn]] void throw_as_exception() const
+    {
+        throw CustomException();
+    }
 
-    REQUIRE_THROWS_AS(errno_error.throw_as_exception(), bowl::ErrnoException);
+    int errnum = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<bowl::Expected<int, TrivialError>>);
+static_assert(std::is_trivially_destructible_v<bowl::Expected<int, TrivialError>>);
+static_assert(!std::is_trivially_copyable_v<bowl::Expected<OkCase, ErrorCase>>);
+static_assert(!std::is_copy_constructible_v<bowl::Expected<OkCase, ErrorCase>>);
+
+TEST_CASE("Trivial Expected can be copied", "[trivial_expected_copy]")
+{
+    bowl::Expected<int, TrivialError> ok_expected(42);
+    bowl::Expected<int, TrivialError> ok_copy = ok_expected;
+
+    REQUIRE(ok_copy.ok());
+    REQUIRE(ok_copy.unpack_ok() == 42);
+    REQUIRE_THROWS_AS(ok_copy.unpack_ok(), bowl::MovedOutException);
+
+    REQUIRE(ok_expected.unpack_ok() == 42);
+
+    TrivialError te;
+    te.errnum = 52;
+    bowl::Expected<int, TrivialError> err_expected{ bowl::Unexpected(std::move(te)) };
+    bowl::Expected<int, TrivialError> err_copy = err_expected;
+
+    REQUIRE(!err_copy.ok());
+    REQUIRE(err_copy.unpack_error().errnum == 52);
+    REQUIRE_THROWS_AS(err_expected.throw_if_error(), CustomException);
 }
 
-TEST_CASE("CustomError works", "[custom_error_works]")
+/* Layout */
+
+// Has a spare byte, which is used as a niche for the state of Expected
+struct Sample
 {
-    bowl::Expected<OkCase, bowl::CustomError> exp{ bowl::Unexpected(bowl::CustomError("foobar")) };
+    int64_t value;
+    int32_t count;
+    uint8_t reserved = 0;
+};
 
-    REQUIRE(!exp.ok());
+template <>
+struct bowl::niche_traits<Sample> : bowl::byte_niche<Sample, offsetof(Sample, reserved)>
+{
+};
 
-    REQUIRE_THROWS_AS(exp.unpack_ok(), bowl::UnpackOkIfErrorException<bowl::CustomError>);
+struct ErrorDescriptor
+{
+    const char* msg;
+};
 
-    bowl::CustomError err2 = exp.unpack_error();
-    REQUIRE(err2.display() == "foobar");
+template <>
+struct bowl::error_traits<const ErrorDescriptor*>
+{
+    static const char* display(const ErrorDescriptor* err)
+    {
+        return err->msg;
+    }
 
-    REQUIRE_THROWS_AS(err2.throw_as_exception(), bowl::CustomException);
+    [[noreturn]] static void throw_as_exception(const ErrorDescriptor*)
+    {
+        throw ::CustomException();
+    }
+};
+
+static_assert(sizeof(bowl::Expected<int64_t, TrivialError>) == 16);
+static_assert(sizeof(bowl::Expected<int32_t, TrivialError>) == 8);
+static_assert(sizeof(bowl::Expected<int64_t, ErrorCase>) == sizeof(ErrorCase) + alignof(ErrorCase));
+static_assert(sizeof(bowl::Unexpected<TrivialError>) == 8);
+static_assert(sizeof(bowl::MaybeError<TrivialError>) == 8);
+
+static_assert(sizeof(bowl::Expected<Sample, TrivialError>) == sizeof(Sample));
+static_assert(sizeof(bowl::MaybeError<bowl::Errno>) == sizeof(int));
+static_assert(sizeof(bowl::Unexpected<bowl::Errno>) == sizeof(int));
+static_assert(sizeof(bowl::MaybeError<const ErrorDescriptor*>) == sizeof(void*));
+
+TEST_CASE("Expected with niche in ok type works", "[expected_niche]")
+{
+    Sample sample;
+    sample.value = 42;
+    sample.count = 3;
+
+    bowl::Expected<Sample, TrivialError> ok_expected(std::move(sample));
+
+    REQUIRE(ok_expected.ok());
+    REQUIRE_THROWS_AS(ok_expected.unpack_error(), bowl::UnpackErrorIfOkException);
+
+    Sample sample2 = ok_expected.unpack_ok();
+    REQUIRE(sample2.value == 42);
+    REQUIRE(sample2.count == 3);
+    REQUIRE(ok_expected.ok());
+    REQUIRE_THROWS_AS(ok_expected.unpack_ok(), bowl::MovedOutException);
+
+    TrivialError te;
+    te.errnum = 52;
+    bowl::Expected<Sample, TrivialError> err_expected{ bowl::Unexpected(std::move(te)) };
+
+    REQUIRE(!err_expected.ok());
+    REQUIRE(err_expected.unpack_error().errnum == 52);
+    REQUIRE(!err_expected.ok());
+    REQUIRE_THROWS_AS(err_expected.unpack_error(), bowl::MovedOutException);
+    REQUIRE_THROWS_AS(err_expected.throw_if_error(), bowl::MovedOutException);
 }
 
-bowl::Expected<int, bowl::CustomError> returning_error()
+TEST_CASE("MaybeError with niche in error type works", "[maybe_error_niche]")
 {
-    return bowl::Unexpected(bowl::CustomError("I'm an error!"));
+    bowl::MaybeError<bowl::Errno> ok_err{};
+
+    REQUIRE(ok_err.ok());
+    REQUIRE_THROWS_AS(ok_err.unpack_error(), bowl::UnpackErrorIfOkException);
+
+    bowl::MaybeError<bowl::Errno> err{ bowl::Unexpected(bowl::Errno::NOENT) };
+
+    REQUIRE(!err.ok());
+    REQUIRE(err.unpack_error() == bowl::Errno::NOENT);
+    REQUIRE(!err.ok());
+    REQUIRE_THROWS_AS(err.unpack_error(), bowl::MovedOutException);
+
+    ErrorDescriptor desc{ "descriptive" };
+    bowl::MaybeError<const ErrorDescriptor*> err2{ &desc };
+
+    REQUIRE(!err2.ok());
+    REQUIRE(err2.unpack_error()->msg == desc.msg);
+
+    bowl::MaybeError<const ErrorDescriptor*> err3{ nullptr };
+
+    REQUIRE(!err3.ok());
+    REQUIRE(err3.unpack_error() == nullptr);
 }
 
-bowl::Expected<int, bowl::CustomError> forwarding_error()
+/* Policies */
+static_assert(std::is_same_v<bowl::DefaultPolicy, bowl::policy::Throw>);
+
+static_assert(sizeof(bowl::Unexpected<TrivialError, bowl::policy::Unchecked>) ==
+              sizeof(TrivialError));
+static_assert(sizeof(bowl::Unexpected<ErrorCase, bowl::policy::Unchecked>) == sizeof(ErrorCase));
+static_assert(sizeof(bowl::Expected<int32_t, TrivialError, bowl::policy::Unchecked>) == 8);
+
+// An error type with exactly one spare pattern, errnum == -1
+class OneNicheError : public TrivialError
 {
-    CHECK_ASSIGN(foo, returning_error());
+};
 
-    return foo;
+// Without moves to track, a single spare pattern is enough to drop the state byte
+template <>
+struct bowl::niche_traits<OneNicheError>
+{
+    static constexpr std::size_t count = 1;
+    static constexpr std::size_t offset = 0;
+
+    static void store(void* x, std::size_t)
+    {
+        int val = -1;
+        std::memcpy(x, &val, sizeof(val));
+    }
+
+    static std::size_t load(const void* x)
+    {
+        int val;
+        std::memcpy(&val, x, sizeof(val));
+        return val == -1 ? 0 : count;
+    }
+};
+
+static_assert(sizeof(bowl::MaybeError<OneNicheError, bowl::policy::Unchecked>) ==
+              sizeof(OneNicheError));
+static_assert(sizeof(bowl::MaybeError<OneNicheError>) == 8);
+
+TEST_CASE("Unchecked Expected works", "[unchecked_expected]")
+{
+    num_constructed = 0;
+    num_copy_constructed = 0;
+
+    OkCase ok;
+    ok.payload = 52;
+
+    bowl::Expected<OkCase, ErrorCase, bowl::policy::Unchecked> ok_expected(std::move(ok));
+
+    REQUIRE(ok_expected.ok());
+    REQUIRE_NOTHROW(ok_expected.throw_if_error());
+    REQUIRE(ok_expected.unpack_ok().payload == 52);
+
+    bowl::Expected<OkCase, ErrorCase, bowl::policy::Unchecked> err_expected{ bowl::Unexpected(
+        ErrorCase()) };
+
+    REQUIRE(!err_expected.ok());
+    REQUIRE_THROWS_AS(err_expected.throw_if_error(), CustomException);
+
+    REQUIRE(num_constructed == 2);
+    REQUIRE(num_copy_constructed == 0);
 }
 
-bowl::Expected<int, bowl::CustomError> returning_value()
+TEST_CASE("Unchecked MaybeError works", "[unchecked_maybe_error]")
 {
-    return 42;
+    bowl::MaybeError<OneNicheError, bowl::policy::Unchecked> ok_err{};
+
+    REQUIRE(ok_err.ok());
+
+    OneNicheError te;
+    te.errnum = 42;
+    bowl::MaybeError<OneNicheError, bowl::policy::Unchecked> err{ std::move(te) };
+
+    REQUIRE(!err.ok());
+    REQUIRE(err.unpack_error().errnum == 42);
+    REQUIRE(!err.ok());
+    REQUIRE_THROWS_AS(err.throw_if_error(), CustomException);
 }
 
-bowl::Expected<int, bowl::CustomError> forwarding_value()
+/* Static error interface */
+static_assert(bowl::is_error_v<ErrorCase>);
+static_assert(bowl::is_error_v<TrivialError>);
+static_assert(bowl::is_error_v<bowl::ErrnoError>);
+static_assert(bowl::is_error_v<bowl::CustomError>);
+static_assert(bowl::is_error_v<bowl::Errno>);
+static_assert(!bowl::is_error_v<OkCase>);
+static_assert(!bowl::is_error_v<int>);
+
+static_assert(sizeof(bowl::ErrnoError) == sizeof(int));
+static_assert(!std::is_polymorphic_v<bowl::ErrnoError>);
+static_assert(std::is_trivially_copyable_v<bowl::Expected<int, bowl::ErrnoError>>);
+static_assert(sizeof(bowl::Expected<int, bowl::ErrnoError>) == 8);
+
+TEST_CASE("ErrorAdapter erases error types", "[error_adapter]")
 {
-    CHECK_ASSIGN(foo, returning_value());
+    errno = ENOENT;
+    std::unique_ptr<bowl::Error> err =
+        std::make_unique<bowl::ErrorAdapter<bowl::ErrnoError>>(bowl::ErrnoError());
 
-    return foo;
+    REQUIRE(err->display() == "No such file or directory");
+    REQUIRE_THROWS_AS(err->throw_as_exception(), bowl::ErrnoException);
+
+    std::unique_ptr<bowl::Error> err2 =
+        std::make_unique<bowl::ErrorAdapter<bowl::CustomError>>(bowl::CustomError("foobar"));
+
+    REQUIRE(err2->display() == "foobar");
+    REQUIRE_THROWS_AS(err2->throw_as_exception(), bowl::CustomException);
 }
 
-TEST_CASE("CHECK_ASSIGN works")
+TEST_CASE("Errno can be used as error type", "[errno_as_error]")
 {
-    auto res = forwarding_error();
+    bowl::Expected<int, bowl::Errno> exp{ bowl::Unexpected(bowl::Errno::NOMEM) };
 
-    REQUIRE(!res.ok());
-    REQUIRE(res.unpack_error().display() == "I'm an error!");
+    REQUIRE(!exp.ok());
+    REQUIRE_THROWS_AS(exp.unpack_ok(), bowl::UnpackOkIfErrorException<bowl::Errno>);
+    REQUIRE_THROWS_AS(exp.throw_if_error(), bowl::ErrnoException);
+}
 
-    auto res2 = forwarding_value();
+/* Combinators */
+
+// Counts all moves and copies, to check that the combinators do not add any
+struct Tracked
+{
+    explicit Tracked(int v) noexcept : value(v)
+    {
+    }
+
+    Tracked(Tracked&& other) noexcept : value(other.value)
+    {
+        moves++;
+    }
+
+    Tracked(const Tracked& other) : value(other.value)
+    {
+        copies++;
+    }
+
+    Tracked& operator=(Tracked&& other)
+    {
+        value = other.value;
+        moves++;
+        return *this;
+    }
+
+    Tracked& operator=(const Tracked& other)
+    {
+        value = other.value;
+        copies++;
+        return *this;
+    }
+
+    static void reset()
+    {
+        moves = 0;
+        copies = 0;
+    }
+
+    static inline uint64_t moves = 0;
+    static inline uint64_t copies = 0;
+
+    int value;
+};
+
+struct TrackedError : Tracked
+{
+    using Tracked::Tracked;
+
+    std::string display() const
+    {
+        return "tracked error " + std::to_string(value);
+    }
+
+    [[noreturn]] void throw_as_exception() const
+    {
+        throw CustomException();
+    }
+};
+
+using TrackedExpected = bowl::Expected<Tracked, TrackedError>;
 
+TEST_CASE("Expected::map() moves at most once per stage", "[expected_map]")
+{
+    TrackedExpected exp{ Tracked(1) };
+    Tracked::reset();
+
+    auto res = std::move(exp)
+                   .map([](Tracked&& t) {
+                       t.value++;
+                       return std::move(t);
+                   })
+                   .map([](Tracked t) { return Tracked(t.value * 10); })
+                   .map([](Tracked&& t) { return Tracked(t.value + 1); })
+                   .map([](Tracked&& t) { return t.value; });
+
+    REQUIRE(Tracked::moves == 2);
+    REQUIRE(Tracked::copies == 0);
+
+    REQUIRE(res.ok());
+    REQUIRE(res.unpack_ok() == 21);
+    REQUIRE_THROWS_AS(exp.unpack_ok(), bowl::MovedOutException);
+}
+
+TEST_CASE("Expected::map() passes errors on", "[expected_map_error_path]")
+{
+    TrackedExpected exp{ bowl::Unexpected(TrackedError(7)) };
+    Tracked::reset();
+
+    bool called = false;
+    auto res = exp.map([&](Tracked&& t) {
+                      called = true;
+                      return std::move(t);
+                  })
+                   .map([&](Tracked&& t) {
+                       called = true;
+                       return std::move(t);
+                   });
+
+    REQUIRE(!called);
+    REQUIRE(Tracked::moves == 2);
+    REQUIRE(Tracked::copies == 0);
+    REQUIRE(res.unpack_error().value == 7);
+}
+
+TEST_CASE("Expected::and_then() and or_else() chain", "[expected_and_then]")
+{
+    auto half = [](int v) -> bowl::Expected<int, TrackedError> {
+        if (v % 2 != 0)
+        {
+            return bowl::Unexpected(TrackedError(v));
+        }
+        return v / 2;
+    };
+
+    bowl::Expected<int, TrackedError> exp{ 8 };
+    auto res = exp.and_then(half).and_then(half).and_then(half).and_then(half);
+
+    REQUIRE(!res.ok());
+    REQUIRE(res.unpack_error().value == 1);
+
+    bowl::Expected<int, TrackedError> exp2{ 12 };
+    Tracked::reset();
+    auto res2 = exp2.and_then(half).and_then(half).and_then(half).or_else(
+        [](TrackedError&& err) -> bowl::Expected<int, bowl::CustomError> {
+            return err.value * 100;
+        });
+
+    // both moves happen when `half` returns the error through Unexpected
+    REQUIRE(Tracked::moves == 2);
+    REQUIRE(Tracked::copies == 0);
     REQUIRE(res2.ok());
-    REQUIRE(res2.unpack_ok() == 42);
+    REQUIRE(res2.unpack_ok() == 300);
+
+    bowl::Expected<int, TrackedError> exp3{ 4 };
+    auto res3 = exp3.or_else([](TrackedError&&) -> bowl::Expected<int, bowl::CustomError> {
+        return bowl::Unexpected(bowl::CustomError("not called"));
+    });
+
+    REQUIRE(res3.unpack_ok() == 4);
+}
+
+TEST_CASE("Expected::map_error() converts errors", "[expected_map_error]")
+{
+    TrackedExpected exp{ bowl::Unexpected(TrackedError(3)) };
+
+    auto res = exp.map_error([](TrackedError&& err) { return bowl::CustomError(err.display()); });
+
+    REQUIRE(!res.ok());
+    REQUIRE(res.unpack_error().display() == "tracked error 3");
+
+    TrackedExpected exp2{ Tracked(5) };
+    Tracked::reset();
+
+    auto res2 = exp2.map_error([](TrackedError&& err) { return bowl::CustomError(err.display()); });
+
+    REQUIRE(Tracked::moves == 1);
+    REQUIRE(res2.unpack_ok().value == 5);
+}
+
+TEST_CASE("Expected::value_or() and value_or_else()", "[expected_value_or]")
+{
+    bowl::Expected<int, TrackedError> ok_exp{ 42 };
+    REQUIRE(ok_exp.value_or(0) == 42);
+    REQUIRE_THROWS_AS(ok_exp.value_or(0), bowl::MovedOutException);
+
+    bowl::Expected<int, TrackedError> err_exp{ bowl::Unexpected(TrackedError(1)) };
+    REQUIRE(err_exp.value_or(23) == 23);
+
+    bool called = false;
+    bowl::Expected<int, TrackedError> ok_exp2{ 42 };
+    REQUIRE(ok_exp2.value_or_else([&] {
+        called = true;
+        return 0;
+    }) == 42);
+    REQUIRE(!called);
+
+    bowl::Expected<int, TrackedError> err_exp2{ bowl::Unexpected(TrackedError(17)) };
+    REQUIRE(err_exp2.value_or_else([](TrackedError&& err) { return err.value + 1; }) == 18);
+
+    bowl::Expected<int, TrackedError> err_exp3{ bowl::Unexpected(TrackedError(17)) };
+    REQUIRE(err_exp3.value_or_else([] { return 5; }) == 5);
+}
+
+TEST_CASE("Combinators accept pointers to members", "[combinators_member_pointers]")
+{
+    Tracked t(7);
+    bowl::Expected<Tracked*, bowl::CustomError> ptr{ &t };
+
+    auto value = ptr.map(&Tracked::value);
+    static_assert(std::is_same_v<decltype(value), bowl::Expected<int&, bowl::CustomError>>);
+    value.unpack_ok() = 8;
+    REQUIRE(t.value == 8);
+}
+
+TEST_CASE("UnpackOkIfErrorException includes the error", "[unpack_ok_if_error_message]")
+{
+    bowl::Expected<int, bowl::CustomError> exp{ bowl::unexpect, "boom" };
+
+    REQUIRE_THROWS_WITH(exp.unpack_ok(),
+                        "Trying to access unpack_ok() but object was in !ok() state, error: boom");
+}
+
+TEST_CASE("MaybeError combinators", "[maybe_error_combinators]")
+{
+    bowl::MaybeError<TrackedError> ok_err{};
+    auto res = ok_err.map([] { return Tracked(3); });
+
+    REQUIRE(res.ok());
+    REQUIRE(res.unpack_ok().value == 3);
+
+    bowl::MaybeError<TrackedError> err{ TrackedError(4) };
+    Tracked::reset();
+    auto res2 = err.map([] { return Tracked(3); });
+
+    REQUIRE(Tracked::moves == 1);
+    REQUIRE(res2.unpack_error().value == 4);
+
+    bowl::MaybeError<TrackedError> ok_err2{};
+    auto res3 = ok_err2.and_then([] { return bowl::MaybeError<TrackedError>(TrackedError(9)); });
+
+    REQUIRE(!res3.ok());
+
+    auto res4 = res3.map_error([](TrackedError&& e) { return bowl::CustomError(e.display()); });
+
+    REQUIRE(res4.unpack_error().display() == "tracked error 9");
+
+    bowl::MaybeError<TrackedError> err2{ TrackedError(4) };
+    auto res5 = err2.or_else([](TrackedError&& e) -> bowl::MaybeError<bowl::CustomError> {
+        if (e.value == 4)
+        {
+            return {};
+        }
+        return bowl::CustomError("unexpected");
+    });
+
+    REQUIRE(res5.ok());
+}
+
+/* In-place construction */
+
+// Neither copyable nor movable, so it can only be constructed in place.
+struct Pinned
+{
+    Pinned(int a, int b) : value(a + b)
+    {
+    }
+
+    Pinned(const Pinned&) = delete;
+    Pinned& operator=(const Pinned&) = delete;
+
+    int value;
+};
+
+bowl::Expected<Pinned, TrackedError> make_pinned(int a, int b)
+{
+    if (a < 0)
+    {
+        return { bowl::unexpect, a };
+    }
+    return { std::in_place, a, b };
+}
+
+TEST_CASE("Expected can be constructed in place", "[expected_in_place]")
+{
+    auto res = make_pinned(1, 2);
+
+    REQUIRE(res.ok());
+    REQUIRE(res.unpack_ok().value == 3);
+
+    Tracked::reset();
+    auto res2 = make_pinned(-1, 2);
+
+    REQUIRE(Tracked::moves == 0);
+    REQUIRE(!res2.ok());
+    REQUIRE(res2.unpack_error().value == -1);
+
+    TrackedExpected exp{ std::in_place, 5 };
+
+    REQUIRE(Tracked::moves == 0);
+    REQUIRE(exp.unpack_ok().value == 5);
+}
+
+TEST_CASE("Expected::emplace_ok() and emplace_error()", "[expected_emplace]")
+{
+    TrackedExpected exp{ bowl::unexpect, 1 };
+    Tracked::reset();
+
+    REQUIRE(exp.emplace_ok(2).value == 2);
+    REQUIRE(exp.ok());
+    REQUIRE(Tracked::moves == 0);
+    REQUIRE(exp.unpack_ok().value == 2);
+
+    // Consumed contents can be replaced, too
+    exp.emplace_error(3);
+
+    REQUIRE(!exp.ok());
+    REQUIRE(exp.unpack_error().value == 3);
+
+    bowl::Expected<int, bowl::CustomError> exp2{ 1 };
+    exp2.emplace_error("emplaced");
+
+    REQUIRE(exp2.unpack_error().display() == "emplaced");
+}
+
+TEST_CASE("MaybeError and Unexpected can be constructed in place", "[maybe_error_in_place]")
+{
+    Tracked::reset();
+    bowl::MaybeError<TrackedError> err{ bowl::unexpect, 4 };
+
+    REQUIRE(Tracked::moves == 0);
+    REQUIRE(!err.ok());
+    REQUIRE(err.unpack_error().value == 4);
+
+    bowl::MaybeError<TrackedError> ok_err{};
+    ok_err.emplace_error(5);
+
+    REQUIRE(Tracked::moves == 0);
+    REQUIRE(ok_err.unpack_error().value == 5);
+
+    bowl::Unexpected<TrackedError> unexp{ std::in_place, 6 };
+
+    REQUIRE(Tracked::moves == 0);
+    REQUIRE(unexp.unpack().value == 6);
+}
+
+/* Moves */
+
+// Not default constructible and not assignable, counts its live instances
+struct Counted
+{
+    explicit Counted(int v) : value(v)
+    {
+        live++;
+    }
+
+    Counted(Counted&& other) noexcept : value(other.value)
+    {
+        live++;
+    }
+
+    Counted& operator=(Counted&&) = delete;
+
+    ~Counted()
+    {
+        live--;
+    }
+
+    static inline int64_t live = 0;
+
+    int value;
+};
+
+struct CountedError : Counted
+{
+    using Counted::Counted;
+
+    std::string display() const
+    {
+        return "counted error " + std::to_string(value);
+    }
+
+    [[noreturn]] void throw_as_exception() const
+    {
+        throw CustomException();
+    }
+};
+
+static_assert(std::is_nothrow_move_constructible_v<bowl::Expected<Counted, CountedError>>);
+static_assert(std::is_nothrow_move_constructible_v<bowl::MaybeError<CountedError>>);
+static_assert(std::is_nothrow_move_constructible_v<bowl::Unexpected<CountedError>>);
+static_assert(std::is_nothrow_move_constructible_v<bowl::Expected<std::string, bowl::CustomError>>);
+
+struct ThrowingMove
+{
+    ThrowingMove() = default;
+    ThrowingMove(ThrowingMove&&)
+    {
+    }
+
+    std::string display() const
+    {
+        return "throwing move";
+    }
+
+    [[noreturn]] void throw_as_exception() const
+    {
+        throw CustomException();
+    }
+};
+
+// Move assignment destroys the payload before moving in the new one, so it is only offered for
+// noexcept moves, while move construction works for every payload
+static_assert(std::is_nothrow_move_assignable_v<bowl::Expected<Counted, CountedError>>);
+static_assert(std::is_nothrow_move_assignable_v<bowl::MaybeError<CountedError>>);
+static_assert(!std::is_move_assignable_v<bowl::Expected<ThrowingMove, CountedError>>);
+static_assert(!std::is_move_assignable_v<bowl::MaybeError<ThrowingMove>>);
+static_assert(std::is_move_constructible_v<bowl::Expected<ThrowingMove, CountedError>>);
+
+TEST_CASE("Expected destroys every payload exactly once", "[expected_moves]")
+{
+    {
+        std::vector<bowl::Expected<Counted, CountedError>> v;
+
+        for (int i = 0; i < 100; i++)
+        {
+            if (i % 3 == 0)
+            {
+                v.emplace_back(bowl::unexpect, i);
+            }
+            else
+            {
+                v.emplace_back(std::in_place, i);
+            }
+        }
+
+        // Growing the vector moves the elements, which leaves moved-from payloads behind
+        REQUIRE(Counted::live == 100);
+
+        REQUIRE(v[3].unpack_error().value == 3);
+        REQUIRE(v[4].unpack_ok().value == 4);
+
+        // Moving a consumed Expected keeps it consumed
+        bowl::Expected<Counted, CountedError> moved{ std::move(v[4]) };
+        REQUIRE_THROWS_AS(moved.unpack_ok(), bowl::MovedOutException);
+
+        v[5] = std::move(v[7]);
+        REQUIRE(v[5].unpack_ok().value == 7);
+        REQUIRE_THROWS_AS(v[7].unpack_ok(), bowl::MovedOutException);
+
+        v[8] = std::move(v[9]);
+        REQUIRE(v[8].unpack_error().value == 9);
+    }
+
+    REQUIRE(Counted::live == 0);
+}
+
+TEST_CASE("MaybeError destroys every error exactly once", "[maybe_error_moves]")
+{
+    {
+        std::vector<bowl::MaybeError<CountedError>> v;
+
+        for (int i = 0; i < 100; i++)
+        {
+            if (i % 2 == 0)
+            {
+                v.emplace_back(bowl::unexpect, i);
+            }
+            else
+            {
+                v.emplace_back();
+            }
+        }
+
+        REQUIRE(Counted::live == 50);
+
+        v[1] = std::move(v[2]);
+        v[4] = std::move(v[3]);
+
+        REQUIRE(v[1].unpack_error().value == 2);
+        REQUIRE(v[4].ok());
+        REQUIRE(Counted::live == 50);
+
+        bowl::Unexpected<CountedError> unexp{ std::in_place, 1 };
+        bowl::Unexpected<CountedError> unexp2{ std::move(unexp) };
+
+        REQUIRE(unexp2.unpack().value == 1);
+    }
+
+    REQUIRE(Counted::live == 0);
+}
+
+/* Move and allocation counts */
+
+// Every heap allocation of the test binary goes through this operator new
+static uint64_t allocations = 0;
+
+void* operator new(std::size_t size)
+{
+    allocations++;
+
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+struct Counts
+{
+    uint64_t moves;
+    uint64_t copies;
+    uint64_t allocations;
+
+    bool operator==(const Counts& other) const
+    {
+        return moves == other.moves && copies == other.copies &&
+               allocations == other.allocations;
+    }
+};
+
+std::ostream& operator<<(std::ostream& os, const Counts& c)
+{
+    return os << "{ moves: " << c.moves << ", copies: " << c.copies
+              << ", allocations: " << c.allocations << " }";
+}
+
+// Moves, copies of Tracked and TrackedError, and allocations during f()
+template <class F>
+Counts count(F&& f)
+{
+    Tracked::reset();
+    uint64_t before = allocations;
+
+    f();
+
+    return { Tracked::moves, Tracked::copies, allocations - before };
+}
+
+TEST_CASE("Constructing Expected in place does not move the payload", "[counts_construct]")
+{
+    REQUIRE(count([] { TrackedExpected exp{ std::in_place, 1 }; }) == Counts{ 0, 0, 0 });
+    REQUIRE(count([] { TrackedExpected exp{ bowl::unexpect, 1 }; }) == Counts{ 0, 0, 0 });
+}
+
+TEST_CASE("Constructing Expected from objects moves the payload once per hop",
+          "[counts_construct_hops]")
+{
+    // The success object is moved into the Expected
+    REQUIRE(count([] { TrackedExpected exp{ Tracked(1) }; }) == Counts{ 1, 0, 0 });
+    // The error is built in the Unexpected, which is moved into the Expected
+    REQUIRE(count([] {
+                TrackedExpected exp{ bowl::Unexpected<TrackedError>(std::in_place, 1) };
+            }) == Counts{ 1, 0, 0 });
+    // The error is moved into the Unexpected, and from there into the Expected
+    REQUIRE(count([] { TrackedExpected exp{ bowl::Unexpected(TrackedError(1)) }; }) ==
+            Counts{ 2, 0, 0 });
+}
+
+TEST_CASE("Moving and unpacking Expected moves the payload once", "[counts_move]")
+{
+    TrackedExpected ok{ std::in_place, 1 };
+    TrackedExpected err{ bowl::unexpect, 2 };
+
+    REQUIRE(count([&] { TrackedExpected moved{ std::move(ok) }; }) == Counts{ 1, 0, 0 });
+    REQUIRE(count([&] { TrackedExpected moved{ std::move(err) }; }) == Counts{ 1, 0, 0 });
+
+    TrackedExpected ok2{ std::in_place, 3 };
+    TrackedExpected err2{ bowl::unexpect, 4 };
+
+    // unpack_ok() and unpack_error() hand out references, moving out of them is up to the caller
+    REQUIRE(count([&] { REQUIRE(ok2.unpack_ok().value == 3); }) == Counts{ 0, 0, 0 });
+    REQUIRE(count([&] { REQUIRE(Tracked(err2.unpack_error()).value == 4); }) == Counts{ 1, 0, 0 });
+}
+
+TrackedExpected make_tracked(bool ok)
+{
+    if (ok)
+    {
+        return { std::in_place, 1 };
+    }
+    return { bowl::unexpect, 2 };
+}
+
+TrackedExpected propagate_tracked(bool ok)
+{
+    CHECK_ASSIGN(t, make_tracked(ok));
+
+    return t;
+}
+
+TEST_CASE("CHECK_ASSIGN moves the payload once", "[counts_check_assign]")
+{
+    // One move out of the result into `t`, one into the returned Expected
+    REQUIRE(count([] { propagate_tracked(true); }) == Counts{ 2, 0, 0 });
+    // The error is moved straight into the returned Expected
+    REQUIRE(count([] { propagate_tracked(false); }) == Counts{ 1, 0, 0 });
+}
+
+bowl::MaybeError<TrackedError> maybe_tracked(bool ok)
+{
+    if (ok)
+    {
+        return {};
+    }
+    return { bowl::unexpect, 1 };
+}
+
+TEST_CASE("MaybeError round trips move the error once per step", "[counts_maybe_error]")
+{
+    REQUIRE(count([] { bowl::MaybeError<TrackedError> err{ bowl::unexpect, 1 }; }) ==
+            Counts{ 0, 0, 0 });
+    REQUIRE(count([] { bowl::MaybeError<TrackedError> err{ TrackedError(1) }; }) ==
+            Counts{ 1, 0, 0 });
+    REQUIRE(count([] { bowl::MaybeError<TrackedError> err = bowl::Unexpected(TrackedError(1)); }) ==
+            Counts{ 2, 0, 0 });
+
+    // MaybeError -> Expected<void> -> MaybeError
+    REQUIRE(count([] {
+                bowl::Expected<void, TrackedError> exp{ maybe_tracked(false) };
+                bowl::MaybeError<TrackedError> back{ std::move(exp) };
+                REQUIRE(back.unpack_error().value == 1);
+            }) == Counts{ 2, 0, 0 });
+
+    REQUIRE(count([] {
+                bowl::Expected<void, TrackedError> exp{ maybe_tracked(true) };
+                bowl::MaybeError<TrackedError> back{ std::move(exp) };
+                REQUIRE(back.ok());
+            }) == Counts{ 0, 0, 0 });
+}
+
+TEST_CASE("Moving heap payloads does not allocate", "[counts_allocations]")
+{
+    const std::string text(100, 'x');
+    bowl::Expected<std::string, bowl::CustomError> exp{ std::string(text) };
+
+    REQUIRE(count([&] {
+                auto moved = std::move(exp);
+                std::string s = moved.unpack_ok();
+            }) == Counts{ 0, 0, 0 });
+    REQUIRE(count([] { bowl::MaybeError<TrackedError> err; }) == Counts{ 0, 0, 0 });
+}
+
+/* Expected<void, E> and Expected<T&, E> */
+
+bowl::Expected<void, bowl::CustomError> check_positive(int v)
+{
+    if (v <= 0)
+    {
+        return { bowl::unexpect, "not positive" };
+    }
+    return {};
+}
+
+bowl::Expected<int, bowl::CustomError> checked_double(int v)
+{
+    CHECK_ASSIGN(unit, check_positive(v));
+
+    return v * 2;
+}
+
+TEST_CASE("Expected<void, E> works", "[expected_void]")
+{
+    auto res = check_positive(1);
+
+    REQUIRE(res.ok());
+    res.unpack_ok();
+    REQUIRE_THROWS_AS(res.unpack_ok(), bowl::MovedOutException);
+
+    auto res2 = check_positive(0);
+
+    REQUIRE(!res2.ok());
+    REQUIRE_THROWS_AS(res2.unpack_ok(), bowl::UnpackOkIfErrorException<bowl::CustomError>);
+    REQUIRE(res2.unpack_error().display() == "not positive");
+
+    REQUIRE(checked_double(2).unpack_ok() == 4);
+    REQUIRE(checked_double(-2).unpack_error().display() == "not positive");
+
+    auto mapped = check_positive(3).map([] { return 3; }).and_then(check_positive);
+    REQUIRE(mapped.ok());
+
+    bool called = false;
+    auto side_effect = bowl::Expected<int, bowl::CustomError>(5).map([&](int) { called = true; });
+    static_assert(std::is_same_v<decltype(side_effect), bowl::Expected<void, bowl::CustomError>>);
+    REQUIRE(called);
+    REQUIRE(side_effect.ok());
+}
+
+TEST_CASE("Expected<void, E> converts from and to MaybeError<E>", "[expected_void_maybe_error]")
+{
+    bowl::MaybeError<TrackedError> err{ bowl::unexpect, 3 };
+    bowl::Expected<void, TrackedError> exp{ std::move(err) };
+
+    REQUIRE(!exp.ok());
+
+    bowl::MaybeError<TrackedError> err2{ std::move(exp) };
+
+    REQUIRE(!err2.ok());
+    REQUIRE(err2.unpack_error().value == 3);
+
+    bowl::Expected<void, TrackedError> ok_exp{ bowl::MaybeError<TrackedError>() };
+    bowl::MaybeError<TrackedError> ok_err = std::move(ok_exp);
+
+    REQUIRE(ok_err.ok());
+
+    auto res = bowl::MaybeError<TrackedError>().and_then(
+        [] { return bowl::Expected<void, TrackedError>(bowl::unexpect, 4); });
+
+    REQUIRE(res.unpack_error().value == 4);
+}
+
+struct Table
+{
+    std::vector<Tracked> rows;
+
+    bowl::Expected<Tracked&, bowl::CustomError> lookup(size_t idx)
+    {
+        if (idx >= rows.size())
+        {
+            return { bowl::unexpect, "no such row" };
+        }
+        return rows[idx];
+    }
+};
+
+bowl::Expected<int, bowl::CustomError> lookup_value(Table& table, size_t idx)
+{
+    CHECK_ASSIGN(row, table.lookup(idx));
+    static_assert(std::is_same_v<decltype(row), Tracked&>);
+
+    return { std::in_place, row.value };
+}
+
+// An Expected<T&, E> can not be made to refer to a temporary
+static_assert(std::is_constructible_v<bowl::Expected<const std::string&, bowl::ErrnoError>,
+                                      std::string&>);
+static_assert(!std::is_constructible_v<bowl::Expected<const std::string&, bowl::ErrnoError>,
+                                       std::string&&>);
+static_assert(!std::is_constructible_v<bowl::Expected<const std::string&, bowl::ErrnoError>,
+                                       const char*>);
+static_assert(!std::is_convertible_v<std::string&&,
+                                     bowl::Expected<const std::string&, bowl::ErrnoError>>);
+
+TEST_CASE("Expected<T&, E> works", "[expected_ref]")
+{
+    static_assert(sizeof(bowl::Expected<Tracked&, TrivialError>) ==
+                  sizeof(bowl::Expected<Tracked*, TrivialError>));
+
+    Table table;
+    table.rows.emplace_back(1);
+    table.rows.emplace_back(2);
+    Tracked::reset();
+
+    auto res = table.lookup(1);
+    REQUIRE(res.ok());
+
+    Tracked& row = res.unpack_ok();
+    REQUIRE(&row == &table.rows[1]);
+
+    REQUIRE(lookup_value(table, 0).unpack_ok() == 1);
+    REQUIRE(lookup_value(table, 2).unpack_error().display() == "no such row");
+
+    auto value = table.lookup(0).map([](Tracked& t) -> Tracked& { return t; });
+    REQUIRE(&value.unpack_ok() == &table.rows[0]);
+
+    REQUIRE(table.lookup(5).value_or(table.rows[1]).value == 2);
+
+    bowl::Expected<Tracked&, bowl::CustomError> exp{ std::in_place, table.rows[0] };
+    exp.emplace_ok(table.rows[1]).value = 7;
+    REQUIRE(table.rows[1].value == 7);
+
+    REQUIRE(Tracked::moves == 0);
+    REQUIRE(Tracked::copies == 0);
+}
+
+TEST_CASE("ErrnoError works", "[errno_error_works]")
+{
+    errno = ENOMEM;
+    bowl::ErrnoError errno_error{};
+
+    REQUIRE(errno_error.errnum() == bowl::Errno::NOMEM);
+    REQUIRE(static_cast<int>(errno_error.errnum()) == ENOMEM);
+    REQUIRE(errno_error.display() == "Cannot allocate memory");
+
+    REQUIRE_THROWS_AS(errno_error.throw_as_exception(), bowl::ErrnoException);
+}
+
+static_assert(bowl::errno_info(bowl::Errno::NOENT).name == "ENOENT");
+static_assert(bowl::errno_info(bowl::Errno::WOULDBLOCK).name == "EAGAIN");
+static_assert(bowl::errno_info(bowl::Errno::NOENT).description == "No such file or directory");
+static_assert(bowl::errno_info(static_cast<bowl::Errno>(0)).name.empty());
+static_assert(bowl::errno_info(static_cast<bowl::Errno>(-1)).description == "Unknown error");
+
+TEST_CASE("Errno table matches strerror()", "[errno_table]")
+{
+    for (std::size_t i = 1; i < bowl::detail::errno_table.size(); i++)
+    {
+        auto info = bowl::errno_info(static_cast<bowl::Errno>(i));
+
+        if (!info.name.empty())
+        {
+            REQUIRE(info.description == strerror(static_cast<int>(i)));
+        }
+    }
+}
+
+/* Syscall results */
+
+using ssize = std::make_signed_t<std::size_t>;
+
+static_assert(sizeof(bowl::MaybeError<bowl::ErrnoError>) == sizeof(int));
+static_assert(sizeof(bowl::Expected<std::size_t, bowl::ErrnoError>) == sizeof(ssize));
+static_assert(sizeof(bowl::Expected<ssize, bowl::ErrnoError>) > sizeof(ssize));
+static_assert(std::is_trivially_copyable_v<bowl::Expected<std::size_t, bowl::ErrnoError>>);
+
+TEST_CASE("MaybeError<ErrnoError> is a single int, 0 on success", "[maybe_error_errno_int]")
+{
+    bowl::MaybeError<bowl::ErrnoError> ok_err{};
+    int raw;
+    std::memcpy(&raw, &ok_err, sizeof(raw));
+
+    REQUIRE(raw == 0);
+    REQUIRE(ok_err.ok());
+
+    bowl::MaybeError<bowl::ErrnoError> err{ bowl::ErrnoError(bowl::Errno::AGAIN) };
+
+    REQUIRE(!err.ok());
+    REQUIRE(err.unpack_error().errnum() == bowl::Errno::AGAIN);
+    REQUIRE_THROWS_AS(err.unpack_error(), bowl::MovedOutException);
+}
+
+TEST_CASE("errno 0 is never taken for success", "[errno_zero]")
+{
+    errno = 0;
+    bowl::MaybeError<bowl::ErrnoError> unset{ bowl::ErrnoError() };
+    REQUIRE(!unset.ok());
+    REQUIRE(unset.unpack_error().errnum() == bowl::Errno::IO);
+
+    bowl::MaybeError<bowl::ErrnoError> zero{ bowl::ErrnoError(bowl::Errno(0)) };
+    REQUIRE(!zero.ok());
+    REQUIRE(zero.unpack_error().errnum() == bowl::Errno::IO);
+
+    bowl::MaybeError<bowl::ErrnoError> raw_zero{ bowl::ErrnoError::from_raw(0) };
+    REQUIRE(!raw_zero.ok());
+    REQUIRE(raw_zero.unpack_error().errnum() == bowl::Errno::IO);
+
+    bowl::Expected<std::size_t, bowl::ErrnoError> word{ bowl::Unexpected(bowl::ErrnoError()) };
+    REQUIRE(!word.ok());
+    REQUIRE(word.unpack_error().errnum() == bowl::Errno::IO);
+
+    bowl::MaybeError<bowl::Errno> plain_zero{ bowl::Unexpected(bowl::Errno(0)) };
+    REQUIRE(!plain_zero.ok());
+    REQUIRE(plain_zero.unpack_error() == bowl::Errno(0));
+}
+
+TEST_CASE("Signed success objects are not packed with errnos", "[expected_errno_signed]")
+{
+    bowl::Expected<long, bowl::ErrnoError> negative{ -5L };
+    REQUIRE(negative.ok());
+    REQUIRE(negative.unpack_ok() == -5);
+
+    bowl::Expected<ssize, bowl::ErrnoError> minus_one{ ssize(-1) };
+    REQUIRE(minus_one.ok());
+    REQUIRE(minus_one.unpack_ok() == -1);
+
+    const auto max = static_cast<std::size_t>(std::numeric_limits<ssize>::max());
+    bowl::Expected<std::size_t, bowl::ErrnoError> largest{ std::size_t(max) };
+    REQUIRE(largest.ok());
+    REQUIRE(largest.unpack_ok() == max);
+}
+
+TEST_CASE("Expected<size_t, ErrnoError> is packed into one word", "[expected_errno_word]")
+{
+    bowl::Expected<std::size_t, bowl::ErrnoError> res{ std::size_t(4096) };
+    ssize raw;
+    std::memcpy(&raw, &res, sizeof(raw));
+
+    REQUIRE(raw == 4096);
+    REQUIRE(res.ok());
+    REQUIRE(res.unpack_ok() == 4096);
+    REQUIRE_THROWS_AS(res.unpack_ok(), bowl::MovedOutException);
+
+    bowl::Expected<std::size_t, bowl::ErrnoError> err{ bowl::unexpect, bowl::Errno::INTR };
+    std::memcpy(&raw, &err, sizeof(raw));
+
+    REQUIRE(raw == -EINTR);
+    REQUIRE(!err.ok());
+    REQUIRE_THROWS_AS(err.unpack_ok(), bowl::UnpackOkIfErrorException<bowl::ErrnoError>);
+    REQUIRE(err.unpack_error().errnum() == bowl::Errno::INTR);
+    REQUIRE_THROWS_AS(err.unpack_error(), bowl::MovedOutException);
+
+    bowl::Expected<ssize, bowl::ErrnoError> zero{ ssize(0) };
+
+    REQUIRE(zero.ok());
+    REQUIRE(zero.map([](ssize n) { return n + 1; }).unpack_ok() == 1);
+
+    err.emplace_ok(std::size_t(7));
+    REQUIRE(err.unpack_ok() == 7);
+}
+
+TEST_CASE("bowl::sys wraps syscalls", "[sys]")
+{
+    auto null = bowl::sys::open("/dev/null", O_WRONLY);
+    REQUIRE(null.ok());
+    int null_fd = null.unpack_ok();
+
+    REQUIRE(bowl::sys::write(null_fd, "abc", 3).unpack_ok() == 3);
+
+    iovec iov[2] = { { const_cast<char*>("ab"), 2 }, { const_cast<char*>("cde"), 3 } };
+    REQUIRE(bowl::sys::writev(null_fd, iov, 2).unpack_ok() == 5);
+    REQUIRE(bowl::sys::close(null_fd).ok());
+
+    auto missing = bowl::sys::open("/nonexistent/file", O_RDONLY);
+    REQUIRE(missing.unpack_error().errnum() == bowl::Errno::NOENT);
+
+    char buf[16] = { 1 };
+    auto bad = bowl::sys::read(-1, buf, sizeof(buf));
+    REQUIRE(bad.unpack_error().errnum() == bowl::Errno::BADF);
+    REQUIRE(bowl::sys::close(-1).unpack_error().errnum() == bowl::Errno::BADF);
+
+    int zero_fd = bowl::sys::open("/dev/zero", O_RDONLY).unpack_ok();
+    REQUIRE(bowl::sys::pread(zero_fd, buf, sizeof(buf), 0).unpack_ok() == sizeof(buf));
+    REQUIRE(buf[0] == 0);
+    REQUIRE(bowl::sys::fstat(zero_fd).map([](struct stat st) { return S_ISCHR(st.st_mode); })
+                .unpack_ok());
+    REQUIRE(bowl::sys::close(zero_fd).ok());
+
+    auto mem = bowl::sys::mmap(nullptr, 4096, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                               -1, 0);
+    REQUIRE(mem.ok());
+    REQUIRE(munmap(mem.unpack_ok(), 4096) == 0);
+
+    int efd = bowl::sys::eventfd(0, EFD_CLOEXEC).unpack_ok();
+    uint64_t val = 3;
+    REQUIRE(bowl::sys::write(efd, &val, sizeof(val)).unpack_ok() == sizeof(val));
+    REQUIRE(bowl::sys::read(efd, &val, sizeof(val)).unpack_ok() == sizeof(val));
+    REQUIRE(val == 3);
+    REQUIRE(bowl::sys::close(efd).ok());
+}
+
+TEST_CASE("MappedFile maps whole files", "[mapped_file]")
+{
+    char path[] = "/tmp/bowl_mapped_XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    REQUIRE(bowl::sys::write(fd, "hello mapped world", 18).unpack_ok() == 18);
+
+    auto res = bowl::MappedFile::open(path, { bowl::MappedFile::Access::sequential, true, true });
+    REQUIRE(res.ok());
+
+    bowl::MappedFile file = res.unpack_ok();
+    REQUIRE(file.view() == "hello mapped world");
+    REQUIRE(file.size() == 18);
+    REQUIRE(file.end() - file.begin() == 18);
+    REQUIRE(file.advise(bowl::MappedFile::Access::random).ok());
+
+    bowl::MappedFile moved = std::move(file);
+    REQUIRE(moved.view() == "hello mapped world");
+    REQUIRE(file.view().empty());
+
+    REQUIRE(ftruncate(fd, 0) == 0);
+    auto empty = bowl::MappedFile::open(path);
+    REQUIRE(empty.unpack_ok().view().empty());
+
+    bowl::sys::close(fd);
+    unlink(path);
+
+    auto missing = bowl::MappedFile::open(path);
+    REQUIRE(missing.unpack_error().errnum() == bowl::Errno::NOENT);
+}
+
+TEST_CASE("Raw syscall returns can be converted", "[sys_from_raw]")
+{
+    REQUIRE(bowl::ErrnoError::from_raw(-EAGAIN).errnum() == bowl::Errno::AGAIN);
+    REQUIRE(bowl::sys::from_raw(12).unpack_ok() == 12);
+    REQUIRE(bowl::sys::from_raw(-EPIPE).unpack_error().errnum() == bowl::Errno::PIPE);
+}
+
+TEST_CASE("ErrnoError can be displayed without allocating", "[errno_error_display_to]")
+{
+    bowl::ErrnoError err = (errno = ENOENT, bowl::ErrnoError());
+
+    REQUIRE(err.name() == "ENOENT");
+    REQUIRE(err.display() == "No such file or directory");
+
+    char buf[64];
+    REQUIRE(err.display_to(buf, sizeof(buf)) == err.display().size());
+    REQUIRE(std::string_view(buf) == "No such file or directory");
+
+    char small[6];
+    REQUIRE(err.display_to(small, sizeof(small)) == err.display().size());
+    REQUIRE(std::string_view(small) == "No su");
+
+    REQUIRE(err.display_to(nullptr, 0) == err.display().size());
+
+    REQUIRE(std::string_view(bowl::ErrnoException(err).what()) == "No such file or directory");
+}
+
+TEST_CASE("CustomError works", "[custom_error_works]")
+{
+    bowl::Expected<OkCase, bowl::CustomError> exp{ bowl::Unexpected(bowl::CustomError("foobar")) };
+
+    REQUIRE(!exp.ok());
+
+    REQUIRE_THROWS_AS(exp.unpack_ok(), bowl::UnpackOkIfErrorException<bowl::CustomError>);
+
+    bowl::CustomError err2 = exp.unpack_error();
+    REQUIRE(err2.display() == "foobar");
+
+    REQUIRE_THROWS_AS(err2.throw_as_exception(), bowl::CustomException);
+}
+
+std::string_view display_custom(bowl::CustomError err)
+{
+    static std::string last;
+    last = err.display();
+    return last;
+}
+
+TEST_CASE("CustomError converts implicitly from strings", "[custom_error_strings]")
+{
+    static_assert(std::is_convertible_v<std::string, bowl::CustomError>);
+    static_assert(std::is_convertible_v<const char*, bowl::CustomError>);
+    static_assert(std::is_convertible_v<std::string_view, bowl::CustomError>);
+
+    std::string msg = "copy initialized";
+    bowl::CustomError err = msg;
+    REQUIRE(err.display() == "copy initialized");
+
+    REQUIRE(display_custom(msg) == "copy initialized");
+    REQUIRE(bowl::Unexpected<bowl::CustomError>(msg + "!").unpack().display() ==
+            "copy initialized!");
+}
+
+TEST_CASE("CustomError does not allocate for literals and short messages", "[custom_error_storage]")
+{
+    static_assert(sizeof(bowl::CustomError) == 32);
+
+    static const char queue_full[] = "queue full, dropping request";
+
+    REQUIRE(count([] {
+                auto err = bowl::CustomError::literal(queue_full);
+                REQUIRE(err.storage() == bowl::CustomError::Storage::literal);
+                REQUIRE(err.c_str() == queue_full);
+
+                bowl::Expected<int, bowl::CustomError> exp{ bowl::Unexpected(std::move(err)) };
+                REQUIRE(exp.unpack_error().display() == queue_full);
+            }) == Counts{ 0, 0, 0 });
+
+    REQUIRE(count([] {
+                bowl::CustomError err(std::string_view("short message"));
+                REQUIRE(err.storage() == bowl::CustomError::Storage::small);
+
+                bowl::CustomError copy = err;
+                bowl::CustomError moved = std::move(err);
+                REQUIRE(copy.display() == "short message");
+                REQUIRE(moved.display() == "short message");
+                REQUIRE(err.display().empty());
+            }) == Counts{ 0, 0, 0 });
+
+    const std::string long_message(100, 'x');
+
+    REQUIRE(count([&] {
+                bowl::CustomError err(long_message);
+                REQUIRE(err.storage() == bowl::CustomError::Storage::heap);
+
+                bowl::CustomError moved = std::move(err);
+                REQUIRE(moved.display() == long_message);
+            }) == Counts{ 0, 0, 1 });
+}
+
+TEST_CASE("Interned CustomErrors share their message", "[custom_error_interned]")
+{
+    const std::string msg = "interned error message, longer than the inline buffer";
+
+    auto first = bowl::CustomError::interned(msg);
+    REQUIRE(first.storage() == bowl::CustomError::Storage::interned);
+    REQUIRE(first.display() == msg);
+
+    REQUIRE(count([&] {
+                auto second = bowl::CustomError::interned(msg);
+                bowl::CustomError copy = second;
+                REQUIRE(second.c_str() == first.c_str());
+                REQUIRE(copy.c_str() == first.c_str());
+            }) == Counts{ 0, 0, 0 });
+}
+
+TEST_CASE("CustomException keeps the message of CustomError", "[custom_exception]")
+{
+    static const char msg[] = "literal message";
+
+    try
+    {
+        bowl::CustomError::literal(msg).throw_as_exception();
+    }
+    catch (bowl::CustomException& ex)
+    {
+        REQUIRE(ex.what() == msg);
+        REQUIRE(ex.error().display() == msg);
+    }
+}
+
+TEST_CASE("FormattedError formats only on display", "[formatted_error]")
+{
+    static_assert(std::is_trivially_copyable_v<bowl::FormattedError>);
+    static_assert(sizeof(bowl::MaybeError<bowl::FormattedError>) == sizeof(bowl::FormattedError));
+
+    enum class Stage
+    {
+        parse = 3,
+    };
+
+    REQUIRE(count([] {
+                bowl::MaybeError<bowl::FormattedError> err =
+                    bowl::FormattedError("short read: {} of {} bytes", 12, 64u);
+                auto copy = err.unpack_error();
+                REQUIRE(std::strcmp(copy.format(), "short read: {} of {} bytes") == 0);
+            }) == Counts{ 0, 0, 0 });
+
+    REQUIRE(bowl::FormattedError("short read: {} of {} bytes", 12, 64u).display() ==
+            "short read: 12 of 64 bytes");
+    REQUIRE(bowl::FormattedError("{} {} {} {}", true, 'x', -1.5, Stage::parse).display() ==
+            "true x -1.5 3");
+    REQUIRE(bowl::FormattedError("opening {}: {}", "config.ini", bowl::Errno::NOENT).display() ==
+            "opening config.ini: No such file or directory");
+    REQUIRE(bowl::FormattedError("{{}} {} {}", 1).display() == "{} 1 {}");
+    REQUIRE(bowl::FormattedError("{} {} {}", 0, INT64_MIN, UINT64_MAX).display() ==
+            "0 -9223372036854775808 18446744073709551615");
+    REQUIRE(bowl::FormattedError("no placeholders").display() == "no placeholders");
+}
+
+TEST_CASE("FormattedError truncates like snprintf", "[formatted_error_display_to]")
+{
+    bowl::FormattedError err("value {} out of range", 12345);
+    char buf[10];
+
+    REQUIRE(err.display_to(buf, sizeof(buf)) == 24);
+    REQUIRE(std::string_view(buf) == "value 123");
+    REQUIRE(err.display_to(nullptr, 0) == 24);
+}
+
+TEST_CASE("FormattedException carries the formatted message", "[formatted_exception]")
+{
+    bowl::Expected<int, bowl::FormattedError> exp{ bowl::Unexpected(
+        bowl::FormattedError("bad index {}", 7)) };
+
+    REQUIRE_THROWS_AS(exp.unpack_ok(), bowl::UnpackOkIfErrorException<bowl::FormattedError>);
+
+    try
+    {
+        bowl::FormattedError("bad index {}", 7).throw_as_exception();
+    }
+    catch (bowl::CustomException& ex)
+    {
+        REQUIRE(std::string_view(ex.what()) == "bad index 7");
+    }
+}
+
+bowl::Expected<int, bowl::CustomError> returning_error()
+{
+    return bowl::Unexpected(bowl::CustomError("I'm an error!"));
+}
+
+bowl::Expected<int, bowl::CustomError> forwarding_error()
+{
+    CHECK_ASSIGN(foo, returning_error());
+
+    return foo;
+}
+
+bowl::Expected<int, bowl::CustomError> returning_value()
+{
+    return 42;
+}
+
+bowl::Expected<int, bowl::CustomError> forwarding_value()
+{
+    CHECK_ASSIGN(foo, returning_value());
+
+    return foo;
+}
+
+TEST_CASE("CHECK_ASSIGN works")
+{
+    auto res = forwarding_error();
+
+    REQUIRE(!res.ok());
+    REQUIRE(res.unpack_error().display() == "I'm an error!");
+
+    auto res2 = forwarding_value();
+
+    REQUIRE(res2.ok());
+    REQUIRE(res2.unpack_ok() == 42);
+}
+
+/* BOWL_TRY */
+
+bowl::Expected<int, bowl::CustomError> sum_values(bool fail)
+{
+    return BOWL_TRY(returning_value()) + BOWL_TRY(fail ? returning_error() : returning_value());
+}
+
+TEST_CASE("BOWL_TRY works in expression position", "[bowl_try]")
+{
+    REQUIRE(sum_values(false).unpack_ok() == 84);
+    REQUIRE(sum_values(true).unpack_error().display() == "I'm an error!");
+}
+
+bowl::Expected<int, TrackedError> try_tracked(bool ok)
+{
+    Tracked t = BOWL_TRY(make_tracked(ok));
+
+    return { std::in_place, t.value };
+}
+
+TEST_CASE("BOWL_TRY moves the payload exactly once", "[bowl_try_moves]")
+{
+    REQUIRE(count([] { REQUIRE(try_tracked(true).unpack_ok() == 1); }) == Counts{ 1, 0, 0 });
+    REQUIRE(count([] { REQUIRE(try_tracked(false).unpack_error().value == 2); }) ==
+            Counts{ 1, 0, 0 });
+}
+
+bowl::MaybeError<TrackedError> try_into_maybe_error(bool ok)
+{
+    BOWL_TRY(make_tracked(ok));
+
+    return {};
+}
+
+TrackedExpected try_from_maybe_error(bool ok)
+{
+    BOWL_TRY(maybe_tracked(ok));
+
+    return { std::in_place, 5 };
+}
+
+TEST_CASE("BOWL_TRY propagates between Expected and MaybeError", "[bowl_try_maybe_error]")
+{
+    REQUIRE(try_into_maybe_error(true).ok());
+    REQUIRE(try_into_maybe_error(false).unpack_error().value == 2);
+
+    REQUIRE(try_from_maybe_error(true).unpack_ok().value == 5);
+    REQUIRE(try_from_maybe_error(false).unpack_error().value == 1);
+}
+
+bowl::Expected<int, bowl::CustomError> try_row(Table& table, size_t idx)
+{
+    Tracked& row = BOWL_TRY(table.lookup(idx));
+    row.value++;
+
+    return { std::in_place, row.value };
+}
+
+TEST_CASE("BOWL_TRY yields references for Expected<T&, E>", "[bowl_try_ref]")
+{
+    Table table;
+    table.rows.emplace_back(41);
+
+    REQUIRE(try_row(table, 0).unpack_ok() == 42);
+    REQUIRE(table.rows[0].value == 42);
+    REQUIRE(try_row(table, 1).unpack_error().display() == "no such row");
+}
+
+template <>
+struct bowl::error_conversion<bowl::ErrnoError, bowl::CustomError>
+{
+    static bowl::CustomError convert(bowl::ErrnoError&& err)
+    {
+        return bowl::CustomError(std::string(err.name()));
+    }
+};
+
+bowl::Expected<int, bowl::CustomError> open_with_custom_error(const char* path)
+{
+    CHECK_ASSIGN(fd, bowl::sys::open(path, O_RDONLY));
+    BOWL_TRY(bowl::sys::close(fd));
+
+    return fd;
+}
+
+TEST_CASE("Errors are converted through error_conversion", "[error_conversion]")
+{
+    REQUIRE(open_with_custom_error("/dev/null").ok());
+    REQUIRE(open_with_custom_error("/nonexistent/file").unpack_error().display() == "ENOENT");
+}
+
+/* Error catalog */
+
+BOWL_CATALOG_ERROR(QueueFull, 0x0101, "queue", "queue {} is full ({} entries)");
+BOWL_CATALOG_ERROR(BadHeader, 0x0201, "parser", "bad \"magic\" in header");
+
+bowl::Expected<int, bowl::CatalogError> push_to_queue(int queue, int size)
+{
+    if (size >= 64)
+    {
+        return bowl::Unexpected(bowl::CatalogError(QueueFull{}, queue, size));
+    }
+    return size + 1;
+}
+
+TEST_CASE("CatalogError is small and formats lazily", "[catalog_error]")
+{
+    static_assert(std::is_trivially_copyable_v<bowl::CatalogError>);
+    static_assert(sizeof(bowl::CatalogError) == 16);
+    static_assert(sizeof(bowl::MaybeError<bowl::CatalogError>) == 16);
+    static_assert(sizeof(bowl::Expected<int, bowl::CatalogError>) == 16);
+
+    REQUIRE(push_to_queue(3, 10).unpack_ok() == 11);
+
+    auto err = push_to_queue(3, 64).unpack_error();
+    REQUIRE(err.id() == 0x0101);
+    REQUIRE(err.param(0) == 3);
+    REQUIRE(err.entry()->category == std::string_view("queue"));
+    REQUIRE(err.display() == "queue 3 is full (64 entries)");
+
+    REQUIRE_THROWS_AS(err.throw_as_exception(), bowl::CatalogException);
+}
+
+enum class QueueId : std::uint32_t
+{
+};
+
+TEST_CASE("CatalogError keeps unsigned parameters unsigned", "[catalog_error_unsigned]")
+{
+    bowl::CatalogError err(QueueFull{}, 3000000000u, -5);
+    REQUIRE(err.id() == 0x0101);
+    REQUIRE(err.param(0) == 3000000000);
+    REQUIRE(err.param(1) == -5);
+    REQUIRE(err.display() == "queue 3000000000 is full (-5 entries)");
+
+    bowl::CatalogError from_enum(QueueFull{}, QueueId(4000000000u), std::uint16_t(65535));
+    REQUIRE(from_enum.display() == "queue 4000000000 is full (65535 entries)");
+
+    // The bits for unsigned parameters do not make an error look like a niche
+    bowl::MaybeError<bowl::CatalogError> maybe{ bowl::CatalogError(QueueFull{}, 1u, 2u) };
+    REQUIRE(!maybe.ok());
+    REQUIRE(maybe.unpack_error().display() == "queue 1 is full (2 entries)");
+}
+
+TEST_CASE("The error catalog can be dumped", "[catalog_dump]")
+{
+    REQUIRE(bowl::catalog_find(0x0201)->name == std::string_view("BadHeader"));
+    REQUIRE(bowl::catalog_find(0x0301) == nullptr);
+
+    std::FILE* file = std::tmpfile();
+    REQUIRE(file != nullptr);
+
+    bowl::dump_catalog(file);
+    std::rewind(file);
+
+    char buf[512];
+    std::size_t len = std::fread(buf, 1, sizeof(buf) - 1, file);
+    buf[len] = '\0';
+    std::fclose(file);
+
+    REQUIRE(std::string_view(buf) ==
+            "{\"id\":257,\"name\":\"QueueFull\",\"category\":\"queue\","
+            "\"message\":\"queue {} is full ({} entries)\"}\n"
+            "{\"id\":513,\"name\":\"BadHeader\",\"category\":\"parser\","
+            "\"message\":\"bad \\\"magic\\\" in header\"}\n");
+}
+
+/* AnyError */
+
+class StorageLayerError : public bowl::Error
+{
+public:
+    explicit StorageLayerError(int block) : block_(block)
+    {
+    }
+
+    std::string display() const override
+    {
+        return "bad block " + std::to_string(block_);
+    }
+
+    void throw_as_exception() const override
+    {
+        throw CustomException();
+    }
+
+    int block() const
+    {
+        return block_;
+    }
+
+private:
+    int block_;
+};
+
+struct OversizedError
+{
+    char context[128] = "oversized";
+
+    const char* display() const
+    {
+        return context;
+    }
+
+    [[noreturn]] void throw_as_exception() const
+    {
+        throw CustomException();
+    }
+};
+
+bowl::Expected<int, bowl::ErrnoError> read_block(int block)
+{
+    if (block < 0)
+    {
+        return bowl::Unexpected(bowl::ErrnoError(bowl::Errno::INVAL));
+    }
+    return block;
+}
+
+bowl::Expected<int, bowl::AnyError> load_block(int block)
+{
+    CHECK_ASSIGN(value, read_block(block));
+
+    if (value > 100)
+    {
+        return bowl::Unexpected(bowl::AnyError(StorageLayerError(value)));
+    }
+    return value;
+}
+
+TEST_CASE("AnyError holds different error types inline", "[any_error]")
+{
+    static_assert(sizeof(bowl::AnyError) == bowl::AnyError::inline_size + sizeof(void*));
+    static_assert(bowl::AnyError::is_inline_v<bowl::FormattedError>);
+    static_assert(!bowl::AnyError::is_inline_v<OversizedError>);
+
+    REQUIRE(count([] {
+                auto err = load_block(-1).unpack_error();
+                REQUIRE(err.is<bowl::ErrnoError>());
+                REQUIRE(err.as<bowl::ErrnoError>()->errnum() == bowl::Errno::INVAL);
+                REQUIRE(err.as<StorageLayerError>() == nullptr);
+                REQUIRE(!err.on_heap());
+            }) == Counts{ 0, 0, 0 });
+
+    auto err = load_block(200).unpack_error();
+    REQUIRE(err.is<StorageLayerError>());
+    REQUIRE(err.as<StorageLayerError>()->block() == 200);
+    REQUIRE(err.display() == "bad block 200");
+    REQUIRE_THROWS_AS(err.throw_as_exception(), CustomException);
+
+    REQUIRE(load_block(7).unpack_ok() == 7);
+}
+
+TEST_CASE("AnyError moves its error without allocating", "[any_error_moves]")
+{
+    REQUIRE(count([] {
+                bowl::AnyError err(TrackedError(1));
+                bowl::AnyError moved = std::move(err);
+                REQUIRE(moved.as<TrackedError>()->value == 1);
+                REQUIRE(!err.is<TrackedError>());
+            }) == Counts{ 2, 0, 0 });
+
+    REQUIRE(count([] {
+                bowl::AnyError err(std::in_place_type<TrackedError>, 2);
+                REQUIRE(err.is<TrackedError>());
+            }) == Counts{ 0, 0, 0 });
+}
+
+TEST_CASE("AnyError keeps oversized errors on the heap", "[any_error_heap]")
+{
+    REQUIRE(count([] {
+                bowl::AnyError err{ OversizedError() };
+                bowl::AnyError moved = std::move(err);
+                REQUIRE(moved.on_heap());
+                REQUIRE(moved.display() == "oversized");
+
+                err = std::move(moved);
+                REQUIRE(err.is<OversizedError>());
+            }) == Counts{ 0, 0, 1 });
+}
+
+/* ErrorSet */
+
+using ParseErrors = bowl::ErrorSet<bowl::ErrnoError, bowl::CatalogError>;
+using LoadErrors = bowl::ErrorSet<bowl::ErrnoError, bowl::CatalogError, bowl::FormattedError>;
+
+static_assert(std::is_trivially_copyable_v<ParseErrors>);
+static_assert(sizeof(ParseErrors) == 20);
+static_assert(sizeof(bowl::MaybeError<ParseErrors>) == sizeof(ParseErrors));
+static_assert(sizeof(bowl::Expected<int, ParseErrors>) == sizeof(ParseErrors));
+static_assert(std::is_same_v<bowl::ErrorSet<bowl::ErrnoError, bowl::Errno>::display_type,
+                             std::string_view>);
+static_assert(std::is_same_v<LoadErrors::display_type, std::string>);
+static_assert(std::is_convertible_v<ParseErrors, LoadErrors>);
+static_assert(!std::is_convertible_v<LoadErrors, ParseErrors>);
+
+bowl::Expected<int, ParseErrors> parse_header(int magic)
+{
+    CHECK_ASSIGN(value, read_block(magic));
+
+    if (value != 0x7f)
+    {
+        return bowl::Unexpected(ParseErrors(bowl::CatalogError(BadHeader{})));
+    }
+    return value;
+}
+
+bowl::Expected<int, LoadErrors> load_file(int magic, int size)
+{
+    CHECK_ASSIGN(header, parse_header(magic));
+
+    if (size > 4096)
+    {
+        return bowl::Unexpected(LoadErrors(bowl::FormattedError("file too large: {}", size)));
+    }
+    return header + BOWL_TRY(read_block(size));
+}
+
+TEST_CASE("ErrorSet widens errors on propagation", "[error_set]")
+{
+    REQUIRE(load_file(0x7f, 10).unpack_ok() == 0x7f + 10);
+
+    auto err = load_file(-1, 10).unpack_error();
+    REQUIRE(err.is<bowl::ErrnoError>());
+    REQUIRE(err.as<bowl::ErrnoError>()->errnum() == bowl::Errno::INVAL);
+    REQUIRE(err.as<bowl::CatalogError>() == nullptr);
+    REQUIRE(err.display() == "Invalid argument");
+
+    err = load_file(0x10, 10).unpack_error();
+    REQUIRE(err.index() == 1);
+    REQUIRE(err.display() == "bad \"magic\" in header");
+
+    err = load_file(0x7f, 5000).unpack_error();
+    REQUIRE(err.is<bowl::FormattedError>());
+    REQUIRE(err.display() == "file too large: 5000");
+    REQUIRE_THROWS_AS(err.throw_as_exception(), bowl::FormattedException);
+
+    std::size_t visited = err.visit([](const auto& e) { return sizeof(e); });
+    REQUIRE(visited == sizeof(bowl::FormattedError));
+}
+
+struct PinnedError
+{
+    explicit PinnedError(int v) : value(v)
+    {
+    }
+
+    PinnedError(PinnedError&&) = delete;
+
+    std::string display() const
+    {
+        return "pinned error " + std::to_string(value);
+    }
+
+    [[noreturn]] void throw_as_exception() const
+    {
+        throw CustomException();
+    }
+
+    int value;
+};
+
+TEST_CASE("ErrorSet constructs members in place", "[error_set_in_place]")
+{
+    bowl::ErrorSet<PinnedError, bowl::CustomError> err(std::in_place_type<PinnedError>, 4);
+
+    REQUIRE(err.as<PinnedError>()->value == 4);
+    REQUIRE(err.display() == "pinned error 4");
+
+    REQUIRE(count([] {
+                bowl::ErrorSet<TrackedError, bowl::CustomError> tracked(
+                    std::in_place_type<TrackedError>, 2);
+                REQUIRE(tracked.display() == "tracked error 2");
+            }) == Counts{ 0, 0, 0 });
+}
+
+TEST_CASE("ErrorSet of non-trivial errors manages its member", "[error_set_members]")
+{
+    using Set = bowl::ErrorSet<TrackedError, bowl::CustomError>;
+
+    REQUIRE(count([] {
+                Set err(TrackedError(1));
+                Set copy = err;
+                Set moved = std::move(err);
+                REQUIRE(copy.as<TrackedError>()->value == 1);
+                REQUIRE(moved.display() == "tracked error 1");
+
+                moved = Set(bowl::CustomError::literal("replaced"));
+                REQUIRE(moved.is<bowl::CustomError>());
+                REQUIRE(moved.display() == "replaced");
+            }) == Counts{ 2, 1, 0 });
+}
+
+/* Error context */
+
+using ContextError = bowl::Contextual<bowl::ErrnoError>;
+
+static_assert(sizeof(ContextError) == 3 * sizeof(void*));
+
+bowl::Expected<int, ContextError> read_named_block(const std::string& name, int block)
+{
+    CHECK_ASSIGN(value, read_block(block).with_context("reading block {} of {}", block, name));
+    return value;
+}
+
+bowl::MaybeError<ContextError> load_volume(int block)
+{
+    std::string name = "volume " + std::to_string(block);
+
+    CHECK_ASSIGN(value, read_named_block(name, block).with_context("loading {}", name));
+    return {};
+}
+
+TEST_CASE("with_context() adds frames which are formatted on display", "[context]")
+{
+    REQUIRE(load_volume(3).ok());
+
+    // The names passed as context are gone by now, the frames have copies of them
+    auto err = load_volume(-1).unpack_error();
+    REQUIRE(err.error().errnum() == bowl::Errno::INVAL);
+    REQUIRE(err.display() == "loading volume -1: reading block -1 of volume -1: Invalid argument");
+    REQUIRE_THROWS_AS(err.throw_as_exception(), bowl::CustomException);
+
+    bowl::MaybeError<bowl::ErrnoError> ok_err{};
+    REQUIRE(ok_err.with_context("never formatted").ok());
+}
+
+TEST_CASE("with_context() does not allocate and resets the arena", "[context_arena]")
+{
+    const bowl::detail::ContextArena& arena = bowl::detail::ContextArena::local();
+    REQUIRE(arena.used() == 0);
+
+    Counts counts = count([&] {
+        bowl::Expected<int, TrackedError> exp{ bowl::Unexpected(TrackedError(5)) };
+        auto res = exp.with_context("step {}", 1).with_context("step {} of {}", 2, "setup");
+        auto err = res.unpack_error();
+        auto copy = err;
+
+        REQUIRE(arena.used() > 0);
+        REQUIRE(copy.error().value == 5);
+    });
+    REQUIRE(counts.copies == 1);
+    REQUIRE(counts.allocations == 0);
+    REQUIRE(arena.used() == 0);
+}
+
+TEST_CASE("with_context() drops frames that do not fit into the arena", "[context_overflow]")
+{
+    const std::string long_name(1000, 'x');
+    ContextError err(bowl::ErrnoError(bowl::Errno::NOENT));
+
+    for (int i = 0; i < 20; i++)
+    {
+        err.add_context("{} {}", i, long_name);
+    }
+
+    // Each frame takes its name padded to 1008 bytes plus a 56 byte ContextFrame, so 7 of them
+    // fit into the 8192 bytes of the arena
+    static_assert(BOWL_CONTEXT_ARENA_SIZE == 8192 && sizeof(bowl::detail::ContextFrame) == 56);
+
+    std::string msg = err.display();
+    REQUIRE(msg.rfind("6 " + long_name + ": 5 ", 0) == 0);
+    REQUIRE(msg.find("0 " + long_name + ": No such file or directory (") != std::string::npos);
+    REQUIRE(msg.substr(msg.size() - 28) == " (13 context frames dropped)");
+}
+
+TEST_CASE("Frames fit again once a long-lived error is gone", "[context_recover]")
+{
+    const std::string long_name(1000, 'x');
+    auto long_lived = std::make_unique<ContextError>(bowl::ErrnoError(bowl::Errno::NOENT));
+    long_lived->add_context("kept for a while");
+
+    // The frames of errors that already died are not reused while `long_lived` pins the arena
+    for (int i = 0; i < 10; i++)
+    {
+        ContextError err(bowl::ErrnoError(bowl::Errno::NOENT));
+        err.add_context("{}", long_name);
+    }
+
+    {
+        ContextError starved(bowl::ErrnoError(bowl::Errno::NOENT));
+        starved.add_context("{}", long_name);
+        REQUIRE(starved.display() == "No such file or directory (1 context frames dropped)");
+    }
+
+    long_lived.reset();
+    REQUIRE(bowl::detail::ContextArena::local().used() == 0);
+
+    ContextError err(bowl::ErrnoError(bowl::Errno::NOENT));
+    for (int i = 0; i < 7; i++)
+    {
+        err.add_context("{}", long_name);
+    }
+    REQUIRE(err.display().find("dropped") == std::string::npos);
+}
+
+TEST_CASE("Errors with context can be passed to other threads", "[context_threads]")
+{
+    const bowl::detail::ContextArena& arena = bowl::detail::ContextArena::local();
+    std::unique_ptr<ContextError> from_worker;
+
+    std::thread([&] {
+        from_worker = std::make_unique<ContextError>(bowl::ErrnoError(bowl::Errno::PIPE));
+        from_worker->add_context("writing {}", std::string("output"));
+    }).join();
+
+    // The worker has exited, its arena lives on and holds the frame
+    REQUIRE(from_worker->display() == "writing output: Broken pipe");
+
+    {
+        ContextError local(bowl::ErrnoError(bowl::Errno::NOENT));
+        local.add_context("on the main thread");
+
+        // Context can only be added on the thread that created the error
+        ContextError copy = *from_worker;
+        copy.add_context("copied");
+        REQUIRE(copy.display() == "writing output: Broken pipe (1 context frames dropped)");
+
+        // Releasing the worker's arena here does not reset the arena of this thread
+        from_worker.reset();
+        REQUIRE(local.display() == "on the main thread: No such file or directory");
+    }
+    REQUIRE(arena.used() == 0);
+
+    // The next thread gets the arena of the exited worker, which is reset on first use
+    std::string display;
+    std::thread([&] {
+        ContextError err(bowl::ErrnoError(bowl::Errno::PIPE));
+        err.add_context("second worker");
+        display = err.display();
+    }).join();
+    REQUIRE(display == "second worker: Broken pipe");
 }